@@ -0,0 +1,144 @@
+#include <cstring>
+#include <assert.h>
+
+#include "attacks.hpp"
+
+namespace Attacks {
+    alignas(64) Magic rookMagics[64];
+    alignas(64) Magic bishopMagics[64];
+
+    // Fancy magics share one table per piece type, sized for the sum of 2^bits over all squares
+    alignas(64) static uint64_t rookTable[0x19000];
+    alignas(64) static uint64_t bishopTable[0x1480];
+
+    alignas(64) uint64_t betweenBB[64][64];
+    alignas(64) uint64_t lineBB[64][64];
+
+    static int8_t const ROOK_DIRS[4][2] = {{1,0}, {-1,0}, {0,1}, {0,-1}};
+    static int8_t const BISHOP_DIRS[4][2] = {{1,1}, {1,-1}, {-1,1}, {-1,-1}};
+
+    // Walk each ray one square at a time. Only used to build the tables.
+    static uint64_t slidingAttack(int8_t const dirs[4][2], uint8_t sq, uint64_t occupancy) {
+        uint64_t attacks = 0;
+        for (uint8_t d = 0; d < 4; d++) {
+            int8_t row = sq / 8 + dirs[d][0];
+            int8_t col = sq % 8 + dirs[d][1];
+            while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+                uint64_t bb = 1ull << (row * 8 + col);
+                attacks |= bb;
+                if (occupancy & bb) break;
+                row += dirs[d][0];
+                col += dirs[d][1];
+            }
+        }
+        return attacks;
+    }
+
+    // Board edges don't change the attack set unless the piece is on that edge
+    static uint64_t relevantMask(int8_t const dirs[4][2], uint8_t sq) {
+        constexpr uint64_t rank1 = 0xffull;
+        constexpr uint64_t rank8 = 0xffull << 56;
+        constexpr uint64_t fileA = 0x0101010101010101ull;
+        constexpr uint64_t fileH = fileA << 7;
+
+        uint64_t edges = ((rank1 | rank8) & ~(rank1 << (8 * (sq / 8))))
+                       | ((fileA | fileH) & ~(fileA << (sq % 8)));
+        return slidingAttack(dirs, sq, 0) & ~edges;
+    }
+
+    #ifndef USE_PEXT
+    // Deterministic xorshift64* so the same magics are found on every run
+    static uint64_t nextRandom(uint64_t& state) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    #endif
+
+    static void initMagics(int8_t const dirs[4][2], Magic magics[64], uint64_t* table) {
+        #ifndef USE_PEXT
+        // Magic search state, PEXT indexes the table directly and needs none of it
+        uint64_t occupancy[4096];
+        uint64_t reference[4096];
+        uint32_t epoch[4096] = {0};
+        uint32_t attempt = 0;
+        uint64_t rng = 0x5EED5EED12345678ull;
+        #endif
+
+        for (uint8_t sq = 0; sq < 64; sq++) {
+            Magic& m = magics[sq];
+            m.mask = relevantMask(dirs, sq);
+            uint8_t bits = __builtin_popcountll(m.mask);
+            m.shift = 64 - bits;
+            m.attacks = (sq == 0) ? table : magics[sq-1].attacks + (1u << (64 - magics[sq-1].shift));
+
+            // Enumerate every subset of the mask with the Carry-Rippler trick
+            uint32_t size = 0;
+            uint64_t b = 0;
+            do {
+                #ifdef USE_PEXT
+                m.attacks[_pext_u64(b, m.mask)] = slidingAttack(dirs, sq, b);
+                #else
+                occupancy[size] = b;
+                reference[size] = slidingAttack(dirs, sq, b);
+                #endif
+                size++;
+                b = (b - m.mask) & m.mask;
+            } while (b);
+
+            #ifndef USE_PEXT
+            // Search for a magic that maps every subset without destructive collisions
+            while (true) {
+                do {
+                    m.magic = nextRandom(rng) & nextRandom(rng) & nextRandom(rng);
+                } while (__builtin_popcountll((m.magic * m.mask) >> 56) < 6);
+
+                attempt++;
+                uint32_t i;
+                for (i = 0; i < size; i++) {
+                    uint32_t idx = m.index(occupancy[i]);
+                    if (epoch[idx] < attempt) {
+                        epoch[idx] = attempt;
+                        m.attacks[idx] = reference[i];
+                    } else if (m.attacks[idx] != reference[i]) {
+                        break;
+                    }
+                }
+                if (i == size) break;
+            }
+            #endif
+        }
+    }
+
+    static void initLines() {
+        for (uint8_t a = 0; a < 64; a++) {
+            for (uint8_t b = 0; b < 64; b++) {
+                uint64_t bbA = 1ull << a;
+                uint64_t bbB = 1ull << b;
+                betweenBB[a][b] = 0;
+                lineBB[a][b] = 0;
+                if (a == b) continue;
+
+                if (rookAttacks(a, 0) & bbB) {
+                    betweenBB[a][b] = rookAttacks(a, bbB) & rookAttacks(b, bbA);
+                    lineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | bbA | bbB;
+                } else if (bishopAttacks(a, 0) & bbB) {
+                    betweenBB[a][b] = bishopAttacks(a, bbB) & bishopAttacks(b, bbA);
+                    lineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | bbA | bbB;
+                }
+            }
+        }
+    }
+
+    void init() {
+        initMagics(ROOK_DIRS, rookMagics, rookTable);
+        initMagics(BISHOP_DIRS, bishopMagics, bishopTable);
+        initLines();
+    }
+
+    // Tables are built once at startup, before any BitBoard is constructed
+    static struct Initializer {
+        Initializer() { init(); }
+    } initializer;
+};
@@ -0,0 +1,130 @@
+#ifndef __ATTACKS_INC_GUARD__
+#define __ATTACKS_INC_GUARD__
+
+#include <cstdint>
+
+#if defined(USE_PEXT) || defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+#include "defines.hpp"
+
+// Process-wide, read-only attack tables shared by every BitBoard.
+// Sliding pieces use fancy magic bitboards by default, build with USE_PEXT
+// (make PEXT=1) to index the same tables with BMI2 _pext_u64. Set-wise slider
+// attacks for whole sides use AVX2 Kogge-Stone fills with USE_AVX2 (make AVX2=1).
+namespace Attacks {
+    struct alignas(64) StepAttacks {
+        uint64_t knight[64];
+        uint64_t king[64];
+        uint64_t pawn[2][64]; // White, black
+    };
+
+    static constexpr uint64_t stepBoard(uint8_t const sq, int8_t const dRow, int8_t const dCol) {
+        int8_t row = sq / 8 + dRow;
+        int8_t col = sq % 8 + dCol;
+        return (row >= 0 && row < 8 && col >= 0 && col < 8) ? 1ull << (row * 8 + col) : 0;
+    }
+
+    static constexpr StepAttacks generateStepAttacks() {
+        StepAttacks t = {};
+        for (uint8_t sq = 0; sq < 64; sq++) {
+            t.knight[sq] = stepBoard(sq, 2, 1) | stepBoard(sq, 2, -1) | stepBoard(sq, -2, 1) | stepBoard(sq, -2, -1)
+                         | stepBoard(sq, 1, 2) | stepBoard(sq, 1, -2) | stepBoard(sq, -1, 2) | stepBoard(sq, -1, -2);
+            t.king[sq] = stepBoard(sq, 1, -1) | stepBoard(sq, 1, 0) | stepBoard(sq, 1, 1) | stepBoard(sq, 0, -1)
+                       | stepBoard(sq, 0, 1) | stepBoard(sq, -1, -1) | stepBoard(sq, -1, 0) | stepBoard(sq, -1, 1);
+            t.pawn[BitBoardState::WHITE][sq] = stepBoard(sq, 1, -1) | stepBoard(sq, 1, 1);
+            t.pawn[BitBoardState::BLACK][sq] = stepBoard(sq, -1, -1) | stepBoard(sq, -1, 1);
+        }
+        return t;
+    }
+
+    // Built at compile time so it lives in read-only data
+    inline constexpr StepAttacks STEP_ATTACKS = generateStepAttacks();
+
+    static inline uint64_t knightAttacks(uint8_t const sq) { return STEP_ATTACKS.knight[sq]; }
+    static inline uint64_t kingAttacks(uint8_t const sq) { return STEP_ATTACKS.king[sq]; }
+    static inline uint64_t pawnAttacks(bool const c, uint8_t const sq) { return STEP_ATTACKS.pawn[c][sq]; }
+
+    struct Magic {
+        uint64_t mask;
+        uint64_t magic;
+        uint64_t* attacks;
+        uint8_t shift;
+
+        inline uint32_t index(uint64_t const occupancy) const {
+            #ifdef USE_PEXT
+            return static_cast<uint32_t>(_pext_u64(occupancy, mask));
+            #else
+            return static_cast<uint32_t>(((occupancy & mask) * magic) >> shift);
+            #endif
+        }
+    };
+
+    alignas(64) extern Magic rookMagics[64];
+    alignas(64) extern Magic bishopMagics[64];
+
+    // Squares attacked by a rook/bishop/queen on sq, including the first blocker in each direction
+    static inline uint64_t rookAttacks(uint8_t const sq, uint64_t const occupancy) {
+        Magic const& m = rookMagics[sq];
+        return m.attacks[m.index(occupancy)];
+    }
+
+    static inline uint64_t bishopAttacks(uint8_t const sq, uint64_t const occupancy) {
+        Magic const& m = bishopMagics[sq];
+        return m.attacks[m.index(occupancy)];
+    }
+
+    static inline uint64_t queenAttacks(uint8_t const sq, uint64_t const occupancy) {
+        return rookAttacks(sq, occupancy) | bishopAttacks(sq, occupancy);
+    }
+
+    // [from][to] squares strictly between two aligned squares, and the full line through them.
+    // Both are empty when the squares don't share a rank, file or diagonal.
+    alignas(64) extern uint64_t betweenBB[64][64];
+    alignas(64) extern uint64_t lineBB[64][64];
+
+    static inline uint64_t between(uint8_t const a, uint8_t const b) { return betweenBB[a][b]; }
+    static inline uint64_t line(uint8_t const a, uint8_t const b) { return lineBB[a][b]; }
+
+    #ifdef USE_AVX2
+    // Kogge-Stone occluded fill, four directions per register. Slides every piece in
+    // gen through the empty squares, doubling the distance each step, and returns
+    // the squares attacked that way, first blocker included. Wrap drops squares that
+    // would come around from the other edge of the board.
+    template<bool Up>
+    static inline __m256i fillAttacks(__m256i gen, __m256i const empty, __m256i const wrap, __m256i const s1) {
+        auto sh = [](__m256i b, __m256i n) { return Up ? _mm256_sllv_epi64(b, n) : _mm256_srlv_epi64(b, n); };
+        __m256i const s2 = _mm256_add_epi64(s1, s1);
+        __m256i const s4 = _mm256_add_epi64(s2, s2);
+        __m256i pro = _mm256_and_si256(empty, wrap);
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, sh(gen, s1)));
+        pro = _mm256_and_si256(pro, sh(pro, s1));
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, sh(gen, s2)));
+        pro = _mm256_and_si256(pro, sh(pro, s2));
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, sh(gen, s4)));
+        return _mm256_and_si256(sh(gen, s1), wrap);
+    }
+
+    // Attacks of all rook movers and all bishop movers of one side, one bitboard per
+    // direction: N, E, NE, NW, S, W, SE, SW. Rays of different pieces in the same
+    // direction never overlap, so per-piece counts can be summed per direction.
+    static inline void slidingAttacks(uint64_t const rooks, uint64_t const bishops, uint64_t const empty,
+                                      uint64_t attacks[8]) {
+        constexpr uint64_t notA = BitBoardState::notAFile;
+        constexpr uint64_t notH = BitBoardState::notHFile;
+        __m256i const gen = _mm256_setr_epi64x(rooks, rooks, bishops, bishops);
+        __m256i const e = _mm256_set1_epi64x(empty);
+        __m256i const up = fillAttacks<true>(gen, e, _mm256_setr_epi64x(~0ull, notA, notA, notH),
+                                             _mm256_setr_epi64x(8, 1, 9, 7));
+        __m256i const down = fillAttacks<false>(gen, e, _mm256_setr_epi64x(~0ull, notH, notA, notH),
+                                                _mm256_setr_epi64x(8, 1, 7, 9));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(attacks), up);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(attacks + 4), down);
+    }
+    #endif
+
+    void init();
+};
+
+#endif
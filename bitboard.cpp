@@ -1,965 +1,1298 @@
-#include "bitboard.hpp"
-#include "evaluate.hpp"
-#include "transpositionTables.hpp"
-
-using namespace BitBoardState;
-
-const BitBoard::MoveData BitBoard::DEFAULT_MOVE = {.isCapture=false, .isCastle=false, .isEnPassant=false, .isPromotion=false};
-const BitBoard::MoveData BitBoard::CAPTURE_MOVE = {.isCapture=true, .isCastle=false, .isEnPassant=false, .isPromotion=false};
-const BitBoard::MoveData BitBoard::EN_PASSANT_MOVE = {.isCapture=true, .isCastle=false, .isEnPassant=true, .isPromotion=false};
-const BitBoard::MoveData BitBoard::CASTLE_MOVE = {.isCapture=false, .isCastle=true, .isEnPassant=false, .isPromotion=false};
-const BitBoard::MoveData BitBoard::PROMOTION_MOVE = {.isCapture=false, .isCastle=false, .isEnPassant=false, .isPromotion=true};
-const BitBoard::MoveData BitBoard::PROMOTE_CAPTURE = {.isCapture=true, .isCastle=false, .isEnPassant=false, .isPromotion=true};
-
-inline uint64_t shiftNorth(uint64_t const b) { return b << 8; }
-inline uint64_t shiftSouth(uint64_t const b) { return b >> 8; }
-
-inline uint64_t shiftEast(uint64_t const b) {return (b << 1) & notAFile;}
-inline uint64_t shiftNoEast(uint64_t const b) {return (b << 9) & notAFile;}
-inline uint64_t shiftSoEast(uint64_t const b) {return (b >> 7) & notAFile;}
-inline uint64_t shiftWest(uint64_t const b) {return (b >> 1) & notHFile;}
-inline uint64_t shiftSoWest(uint64_t const b) {return (b >> 9) & notHFile;}
-inline uint64_t shiftNoWest(uint64_t const b) {return (b << 7) & notHFile;}
-
-BitBoard::BitBoard(TT* _tt, bool startpos) {
-    tt = _tt;
-
-    if (tt) {
-        tt->clear();
-    }
-
-    moves = 0;
-    if (startpos) {
-        p[0] = {.pawn=0xff00,.knight=0x42,.bishop=0x24,.rook=0x81,.queen=0x8,.king=0x10};
-        p[1] = {.pawn=0xff000000000000ull,.knight=0x4200000000000000ull,
-                .bishop=0x2400000000000000ull,.rook=0x8100000000000000ull,
-                .queen=0x800000000000000ull,.king=0x1000000000000000ull};
-
-        s[0] = s[1] = {.occupancy=0,.scope=0,.mobility=0,.enPassantSquare=0,
-                        .castleShort=true,.castleLong=true};
-    } else {
-        p[0] = p[1] = {.pawn=0,.knight=0,.bishop=0,.rook=0,.queen=0,.king=0};
-        s[0] = s[1] = {.occupancy=0,.scope=0,.mobility=0,.enPassantSquare=0,
-                        .castleShort=false,.castleLong=false};
-    }
-
-    turn = WHITE;
-    if (tt) {
-        hash = tt->genHash(*this);
-    }
-    value = 0;
-
-    for (uint8_t pos = 0; pos < 64; pos++) {
-        uint64_t attacks = 0;
-        uint64_t sftBoard = 1ull << pos;
-
-        attacks |= shiftNorth(shiftNoEast(sftBoard));
-        attacks |= shiftNorth(shiftNoWest(sftBoard));
-
-        attacks |= shiftEast(shiftNoEast(sftBoard));
-        attacks |= shiftEast(shiftSoEast(sftBoard));
-        
-        attacks |= shiftSouth(shiftSoEast(sftBoard));
-        attacks |= shiftSouth(shiftSoWest(sftBoard));
-        
-        attacks |= shiftWest(shiftNoWest(sftBoard));
-        attacks |= shiftWest(shiftSoWest(sftBoard));
-
-        knightAttacks[pos] = attacks;
-
-        // Pawn angle attacks
-        attacks = shiftNoEast(sftBoard);
-        attacks |= shiftNoWest(sftBoard);
-        pawnAttacks[0][pos] = attacks;
-        attacks = shiftSoEast(sftBoard);
-        attacks |= shiftSoWest(sftBoard);
-        pawnAttacks[1][pos] = attacks;
-
-        // King attacks
-        attacks = shiftNorth(sftBoard);
-        attacks |= shiftSoEast(sftBoard);
-        attacks |= shiftEast(sftBoard);
-        attacks |= shiftNoEast(sftBoard);
-        attacks |= shiftNoWest(sftBoard);
-        attacks |= shiftSouth(sftBoard);
-        attacks |= shiftWest(sftBoard);
-        attacks |= shiftSoWest(sftBoard);
-        kingAttacks[pos] = attacks;
-    }
-    recalculateOccupancy();
-    recalculateThreats();
-}
-
-void BitBoard::recalculateOccupancy() {
-    for (uint8_t turn = WHITE; turn <= BLACK; turn++) {
-        s[turn].occupancy = p[turn].pawn | p[turn].bishop 
-                                        | p[turn].knight | p[turn].rook
-                                        | p[turn].queen | p[turn].king;
-    }
-
-    assert((s[0].occupancy ^ s[1].occupancy) 
-            == (s[0].occupancy | s[1].occupancy));
-}
-
-void BitBoard::recalculateThreats() {
-    for (uint8_t c = WHITE; c <= BLACK; c++) {
-        s[c].mobility = 0;
-        s[c].scope = 0;
-        uint64_t friendly = ~s[c].occupancy;
-        uint64_t enemy = ~s[!c].occupancy;
-
-        uint64_t sliding = p[c].rook | p[c].queen;
-        uint64_t angle = p[c].bishop | p[c].queen;
-
-        uint64_t bb = p[c].knight;
-        while (bb) {
-            // Isolate the least significant bit and find it
-            uint8_t pos = __builtin_ctzll(bb);
-            uint64_t attacks = knightAttacks[pos];
-            s[c].mobility |= attacks;
-            // Clear last least significant bit
-            s[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
-            bb &= bb - 1;
-        }
-
-        bb = p[c].king;
-        while (bb) {
-            uint8_t pos = __builtin_ctzll(bb);
-            uint64_t attacks = kingAttacks[pos];
-            s[c].mobility |= attacks;
-            s[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
-            bb &= bb - 1;
-        }
-
-        bb = p[c].pawn;
-        while (bb) {
-            uint8_t pos = __builtin_ctzll(bb);
-            uint64_t attacks = pawnAttacks[c][pos];
-            s[c].mobility |= attacks;
-            s[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
-            bb &= bb - 1;
-        }
-
-
-        auto slidingFuncs = {&shiftNorth, &shiftEast, &shiftSouth, &shiftWest};
-        for (auto func : slidingFuncs) {
-            bb = sliding;
-            while (bb) {
-                bb = func(bb);
-                s[c].mobility |= bb;
-                s[c].scope += __builtin_popcountll(bb & (~enemy | ~friendly));
-                bb &= friendly;
-                bb &= enemy;
-            }
-        }
-
-        auto angleFuncs = {&shiftNoEast, &shiftNoWest, &shiftSoEast, &shiftSoWest};
-        for (auto func : angleFuncs) {
-            uint64_t bb = angle;
-            while (bb) {
-                bb = func(bb);
-                s[c].mobility |= bb;
-                s[c].scope += __builtin_popcountll(bb & (~enemy | ~friendly));
-                bb &= friendly;
-                bb &= enemy;
-            }
-        }
-    }
-}
-
-int32_t BitBoard::getPieceValue(Piece const& piece) const
-{
-    int32_t value;
-    bool isEndgame = moves > ENDGAME_CUTOFF;
-    switch(piece) {
-        case PAWN:
-            value = isEndgame ? PAWN_VALUE_EG : PAWN_VALUE_MG;
-            break;
-        case KNIGHT:
-            value = isEndgame ? KNIGHT_VALUE_EG : KNIGHT_VALUE_MG;
-            break;
-        case BISHOP:
-            value = isEndgame ? BISHOP_VALUE_EG : BISHOP_VALUE_MG;
-            break;
-        case ROOK:
-            value = isEndgame ? ROOK_VALUE_EG : ROOK_VALUE_MG;
-            break;
-        case QUEEN:
-            value = isEndgame ? QUEEN_VALUE_EG : QUEEN_VALUE_MG;
-            break;
-        case KING:
-            value = KING_STRENGTH_VALUE;
-            break;
-        case EMPTY:
-            value = 0;
-            break;
-        default:
-            assert(0);
-    }
-    return value;
-}
-
-enum Piece BitBoard::getPiece(struct Pieces const& p, uint8_t pos) const
-{
-    return ((p.pawn >> pos) & 0x1) ? PAWN :
-            ((p.knight >> pos) & 0x1) ? KNIGHT :
-            ((p.bishop >> pos) & 0x1) ? BISHOP :
-            ((p.rook >> pos) & 0x1) ? ROOK :
-            ((p.king >> pos) & 0x1) ? KING :
-            ((p.queen >> pos) & 0x1) ? QUEEN : EMPTY;
-}
-
-void BitBoard::maskClearBitBoard(enum Piece piece, bool c, uint64_t m) {
-    struct Pieces& bitboard = p[c];
-    switch(piece) {
-        case PAWN:
-            bitboard.pawn &= ~m;
-            break;
-        case KNIGHT:
-            bitboard.knight &= ~m;
-            break;
-        case BISHOP:
-            bitboard.bishop &= ~m;
-            break;
-        case ROOK:
-            bitboard.rook &= ~m;
-            break;
-        case KING:
-            bitboard.king &= ~m;
-            break;
-        case QUEEN:
-            bitboard.queen &= ~m;
-            break;
-        default:
-            break;
-    }
-}
-
-void BitBoard::maskSetBitBoard(enum Piece piece, bool c, uint64_t m) {
-    struct Pieces& bitboard = p[c];
-    switch(piece) {
-        case PAWN:
-            bitboard.pawn |= m;
-            break;
-        case KNIGHT:
-            bitboard.knight |= m;
-            break;
-        case BISHOP:
-            bitboard.bishop |= m;
-            break;
-        case ROOK:
-            bitboard.rook |= m;
-            break;
-        case KING:
-            bitboard.king |= m;
-            break;
-        case QUEEN:
-            bitboard.queen |= m;
-            break;
-        default:
-            assert(0);
-            break;
-    }
-}
-
-void BitBoard::changeTurn() {
-    hash ^= TURN_HASH_WHITE;
-    turn = static_cast<Color>(turn ^ BLACK); // BLACK == 1
-}
-
-void BitBoard::strToMove(std::string const& moveText, struct Move& move) {
-    assert(moveText.size() == 4 || moveText.size() == 5);
-
-    uint8_t col = moveText[0] - 'a';
-    uint8_t row = moveText[1] - '0' - 1;
-    uint8_t idx = (row<<3) | col;
-    assert(idx < 64);
-    move.from = idx;
-
-    col = moveText[2] - 'a';
-    row = moveText[3] - '0' - 1;
-    idx = idx = (row<<3) | col;
-    assert(idx < 64);
-    move.to = idx;
-
-    if (moveText.size() == 5) {
-        switch(moveText[4]) {
-            case 'n':
-                move.promote = static_cast<Piece>(KNIGHT);
-                break;
-            case 'b':
-                move.promote = static_cast<Piece>(BISHOP);
-                break;
-            case 'r':
-                move.promote = static_cast<Piece>(ROOK);
-                break;
-            case 'q':
-                move.promote = static_cast<Piece>(QUEEN);
-                break;
-            default:
-                assert(0);
-        }
-    } else {
-        move.promote = EMPTY;
-    }
-}
-
-std::string BitBoard::moveToStr(struct Move const& move) {
-    char colF = 'a' + (move.from & 7);
-    char rowF = '1' + (move.from >> 3);
-    char colT = 'a' + (move.to & 7);
-    char rowT = '1' + (move.to >> 3);
-    std::string moveStr;
-    moveStr.append(1, colF);
-    moveStr.append(1, rowF);
-    moveStr.append(1, colT);
-    moveStr.append(1, rowT);
-    if (move.promote != EMPTY) {
-        switch(move.promote) {
-            case KNIGHT:
-                moveStr.append(1, 'n');
-                break;
-            case BISHOP:
-                moveStr.append(1, 'b');
-                break;
-            case ROOK:
-                moveStr.append(1, 'r');
-                break;
-            case QUEEN:
-                moveStr.append(1, 'q');
-                break;
-            default:
-                assert(0);
-        }
-    }
-    return moveStr;
-}
-std::string BitBoard::pieceToUnicode(enum Piece piece, enum Color c) const {
-    std::string pieceChar = "?";
-    if (c == WHITE) {
-        switch(piece) {
-            case EMPTY:
-                pieceChar = ".";
-                break;
-            case PAWN:
-                pieceChar = "\u265f";
-                break;
-            case ROOK:
-                pieceChar = "\u265c";
-                break;
-            case BISHOP:
-                pieceChar = "\u265d";
-                break;
-            case KNIGHT:
-                pieceChar = "\u265e";
-                break;
-            case KING:
-                pieceChar = "\u265a";
-                break;
-            case QUEEN:
-                pieceChar = "\u265b";
-                break;
-            default:
-                assert(0);
-                break;
-        }
-    } else if (c == BLACK) {
-        switch(piece) {
-            case EMPTY:
-                pieceChar = ".";
-                break;
-            case PAWN:
-                pieceChar = "\u2659";
-                break;
-            case ROOK:
-                pieceChar = "\u2656";
-                break;
-            case BISHOP:
-                pieceChar = "\u2657";
-                break;
-            case KNIGHT:
-                pieceChar = "\u2658";
-                break;
-            case KING:
-                pieceChar = "\u2654";
-                break;
-            case QUEEN:
-                pieceChar = "\u2655";
-                break;
-            default:
-                assert(0);
-                break;
-        }
-    }
-    return pieceChar;
-}
-
-int32_t BitBoard::getBoardValue() const {
-    int32_t value = 0;
-    for (uint8_t c = WHITE; c <= BLACK; c++) {
-        int8_t count = __builtin_popcountll(p[c].pawn);
-        value += getPieceValue(PAWN)*count*(c==turn ? 1 : -1);
-
-        count = __builtin_popcountll(p[c].bishop);
-        value += getPieceValue(BISHOP)*count*(c==turn ? 1 : -1);
-
-        count = __builtin_popcountll(p[c].knight);
-        value += getPieceValue(KNIGHT)*count*(c==turn ? 1 : -1);
-
-        count = __builtin_popcountll(p[c].rook);
-        value += getPieceValue(ROOK)*count*(c==turn ? 1 : -1);
-
-        count = __builtin_popcountll(p[c].queen);
-        value += getPieceValue(QUEEN)*count*(c==turn ? 1 : -1);
-    }
-    return value;
-}
-
-void BitBoard::printBoard() const {
-    std::cout << std::endl;
-    for (uint8_t row = 8; row > 0; row--) {
-        std::cout << std::to_string(row) << " ";
-        for (uint8_t col = 0; col < 8; col++) {
-            uint8_t pos = ((row-1)<<3) | col;
-            enum Piece piece = static_cast<Piece>(getPiece(p[0], pos) | getPiece(p[1], pos));
-            Color turn = ((s[0].occupancy >> pos) & 0x1) ? WHITE : BLACK;
-            std::cout << pieceToUnicode(piece, turn) << " ";
-        }
-        std::cout << std::endl;
-    }
-    
-    std::cout << "* ";
-    for (uint8_t col = 0; col < 8; col++) {
-        char colChar = 'a' + col;
-        std::cout << colChar << " ";
-    }
-    std::cout << std::endl;
-    std::cout << "Material Imbalance: " << std::to_string(value) << std::endl;
-    std::cout << "Turn: " << (turn == WHITE ? "White" : "Black") << std::endl;
-    std::cout << "Board hash: 0x" << std::hex << hash << std::endl;
-}
-
-void BitBoard::printMobility() const {
-    for (uint8_t c = WHITE; c <= BLACK; c++) {
-        std::cout << "Mobility[" << (c == WHITE ? "white" : "black") << "]: 0x" << std::hex << s[c].mobility << std::endl;
-        std::cout << "Scope[" << (c == WHITE ? "white" : "black") << "]: " << std::dec << s[c].scope << std::endl;
-        std::cout << "Occupancy[" << (c == WHITE ? "white" : "black") << "]: 0x" << std::hex << s[c].occupancy << std::endl;
-
-        for (uint8_t row = 8; row > 0; row--) {
-            std::cout << std::to_string(row) << " ";
-            for (uint8_t col = 0; col < 8; col++) {
-                uint8_t pos = ((row-1)<<3) | col;
-                std::cout << (((s[c].mobility >> pos) & 0x1) ? "X" : " ") << " ";
-            }
-            std::cout << std::endl;
-        }
-        
-        std::cout << "* ";
-        for (uint8_t col = 0; col < 8; col++) {
-            char colChar = 'a' + col;
-            std::cout << colChar << " ";
-        }
-        std::cout << std::endl;
-        std::cout << std::endl;
-    }
-}
-
-void BitBoard::validateBitBoard() const {
-    #ifdef ASSERT_ON
-    assert((hash == tt->genHash(*this)));
-    #endif
-}
-
-void BitBoard::movePiece(struct Move const& move) {
-    uint8_t from = move.from;
-    uint8_t to = move.to;
-    uint64_t fromBitboard = 1ull << from;
-    uint64_t toBitboard = 1ull << to;
-
-    enum Piece fromPiece = getPiece(p[turn], from);
-    enum Piece toPiece = getPiece(p[!turn], to);
-
-    hash ^= tt->BOARDPOS_HASH[turn][fromPiece][from];
-    if (toPiece) hash ^= tt->BOARDPOS_HASH[!turn][toPiece][to];
-
-    maskClearBitBoard(fromPiece, turn, fromBitboard);
-    maskClearBitBoard(toPiece, !turn, toBitboard);
-
-    // Promote
-    if (move.promote != EMPTY) {
-        fromPiece = move.promote;
-    }
-    
-    hash ^= tt->BOARDPOS_HASH[turn][fromPiece][to];
-    maskSetBitBoard(fromPiece, turn, toBitboard);
-
-    // En Passant
-    if (fromPiece == PAWN && s[turn].enPassantSquare != 0 && s[turn].enPassantSquare == to) {
-        maskClearBitBoard(PAWN, !turn, turn ? toBitboard << 8ull : toBitboard >> 8ull);
-        hash ^= tt->BOARDPOS_HASH[!turn][PAWN][turn ? to+8 : to-8];
-    }
-
-    hash ^= EN_PASSANT_HASH*s[turn].enPassantSquare;
-    s[turn].enPassantSquare = 0;
-    if (fromPiece == PAWN && (to-from) == 16) {
-        s[BLACK].enPassantSquare = from + 8;
-    } else if (fromPiece == PAWN && (from-to) == 16) {
-        s[WHITE].enPassantSquare = to + 8;
-    }
-    hash ^= EN_PASSANT_HASH*s[!turn].enPassantSquare;
-
-    // Castling
-    if (fromPiece == KING && s[turn].castleShort && to-from == 2) {
-        if (s[turn].castleShort) hash ^= turn ? BLACK_CASTLE_SHORT_HASH : WHITE_CASTLE_SHORT_HASH;
-        if (s[turn].castleLong) hash ^= turn ? BLACK_CASTLE_LONG_HASH : WHITE_CASTLE_LONG_HASH;
-        s[turn].castleShort = false;
-        s[turn].castleLong = false;
-
-        maskClearBitBoard(ROOK, turn, toBitboard<<1ull);
-        maskSetBitBoard(ROOK, turn, toBitboard>>1ull);
-        hash ^= tt->BOARDPOS_HASH[turn][ROOK][to-1];
-        hash ^= tt->BOARDPOS_HASH[turn][ROOK][to+1];
-    } else if (fromPiece == KING && s[turn].castleLong && from-to == 2) {
-        if (s[turn].castleShort) hash ^= turn ? BLACK_CASTLE_SHORT_HASH : WHITE_CASTLE_SHORT_HASH;
-        if (s[turn].castleLong) hash ^= turn ? BLACK_CASTLE_LONG_HASH : WHITE_CASTLE_LONG_HASH;
-        s[turn].castleShort = false;
-        s[turn].castleLong = false;
-
-        maskClearBitBoard(ROOK, turn, toBitboard>>2ull);
-        maskSetBitBoard(ROOK, turn, toBitboard<<1ull);
-        hash ^= tt->BOARDPOS_HASH[turn][ROOK][to-2];
-        hash ^= tt->BOARDPOS_HASH[turn][ROOK][to+1];
-    } 
-
-    // Can no longer castle because moved king or rook:
-    else if (fromPiece == KING) {
-        if (s[turn].castleShort) hash ^= turn ? BLACK_CASTLE_SHORT_HASH : WHITE_CASTLE_SHORT_HASH;
-        if (s[turn].castleLong) hash ^= turn ? BLACK_CASTLE_LONG_HASH : WHITE_CASTLE_LONG_HASH;
-        s[turn].castleShort = false;
-        s[turn].castleLong = false;
-    } else if (s[turn].castleShort && fromPiece == ROOK && (from % 8 == 7) && (from / 8 == turn*7)) {
-        s[turn].castleShort = false;
-        hash ^= turn ? BLACK_CASTLE_SHORT_HASH : WHITE_CASTLE_SHORT_HASH;
-    } else if (s[turn].castleLong && fromPiece == ROOK && (from % 8 == 0) && (from / 8 == turn*7)) {
-        s[turn].castleLong = false;
-        hash ^= turn ? BLACK_CASTLE_LONG_HASH : WHITE_CASTLE_LONG_HASH;
-    }
-
-    // Can no longer castle becaue our rook was captured
-    if (s[!turn].castleShort && toPiece == ROOK && (to % 8 == 7) && (to / 8 == (!turn)*7)) {
-        s[!turn].castleShort = false;
-        hash ^= turn ? WHITE_CASTLE_SHORT_HASH : BLACK_CASTLE_SHORT_HASH;
-    } else if (s[!turn].castleLong && toPiece == ROOK && (to % 8 == 0) && (to / 8 == (!turn)*7)) {
-        s[!turn].castleLong = false;
-        hash ^= turn ? WHITE_CASTLE_LONG_HASH : BLACK_CASTLE_LONG_HASH;
-    }
-
-    changeTurn();
-    moves++;
-
-    recalculateOccupancy();
-    recalculateThreats();
-    validateBitBoard();
-}
-
-bool BitBoard::isAvailable(uint8_t const pos) const {
-    return !((s[turn].occupancy >> pos) & 0x1);
-}
-
-bool BitBoard::isOccupied(uint8_t const pos) const {
-    return ((s[0].occupancy >> pos) & 0x1) || ((s[1].occupancy >> pos) & 0x1);
-}
-
-void BitBoard::maskIfPositionAttacked(uint64_t& bb, bool c) const {
-    uint64_t occupied = ~(s[c].occupancy | s[!c].occupancy);
-
-    uint8_t pos = __builtin_ctzll(bb);
-    
-    uint64_t sliding = p[!c].rook | p[!c].queen;
-    uint64_t angle = p[!c].bishop | p[!c].queen;
-
-    uint64_t knight = knightAttacks[pos] & p[!c].knight;
-    uint64_t pawn = pawnAttacks[c][pos] & p[!c].pawn;
-    uint64_t kingEnemy = kingAttacks[pos] & p[!c].king;
-
-    if (knight | pawn | kingEnemy) {
-        bb = 0;
-        return;
-    }
-
-    auto slidingFuncs = {&shiftNorth, &shiftEast, &shiftSouth, &shiftWest};
-    for (auto func : slidingFuncs) {
-        uint64_t sft = bb;
-        while (sft) {
-            sft = func(sft);
-            if (sft & sliding) {
-                bb = 0;
-                return;
-            }
-            sft &= occupied;
-        }
-    }
-
-    auto angleFuncs = {&shiftNoEast, &shiftNoWest, &shiftSoEast, &shiftSoWest};
-    for (auto func : angleFuncs) {
-        uint64_t sft = bb;
-        while (sft) {
-            sft = func(sft);
-            if (sft & angle) {
-                bb = 0;
-                return;
-            }
-            sft &= occupied;
-        }
-    }
-}
-
-inline uint32_t BitBoard::searchStraight(uint64_t bitboard, uint64_t shiftFunc(uint64_t const b), 
-                                        std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const
-{
-    uint8_t pos, newpos;
-    uint32_t numMoves = 0;
-
-    uint64_t friendly = ~s[turn].occupancy;
-    uint64_t enemy = ~s[!turn].occupancy;
-
-    while (bitboard) {
-        // Isolate the least significant bit and find it
-        uint64_t sftBoard = bitboard & -bitboard;
-        pos = __builtin_ctzll(bitboard);
-
-        while((sftBoard = shiftFunc(sftBoard))) {
-            // Piece is blocked by our own
-            if (!(sftBoard = sftBoard & friendly)) break;
-
-            if (!capturesOnly || (sftBoard & ~enemy)) {
-                newpos = __builtin_ctzll(sftBoard);
-                *(moves++) = Move(pos, newpos, (sftBoard & ~enemy) ? CAPTURE_MOVE : DEFAULT_MOVE);
-                numMoves++;
-            }
-
-            // Cut path at enemy pieces
-            sftBoard &= enemy;
-        }
-        // Clear last least significant bit
-        bitboard &= bitboard - 1;
-    }
-    return numMoves;
-}
-
-uint32_t BitBoard::getPawnMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const {
-    uint8_t pos, newpos;
-    uint64_t bb = p[turn].pawn;
-    
-    uint64_t ep = 1ull << s[turn].enPassantSquare;
-    // Magic to get rid of the last bit because that means invalid ep
-    ep >>= 1;
-    ep <<= 1;
-    
-    auto shiftFunc = (turn == WHITE) ? &shiftNorth : &shiftSouth;
-    uint32_t numMoves = 0;
-    uint64_t friendly = ~s[turn].occupancy;
-    uint64_t enemy = ~s[!turn].occupancy;
-
-    while (bb) {
-        // Isolate the least significant bit and find it
-        uint64_t sftBoard = bb & -bb;
-        pos = __builtin_ctzll(bb);
-
-        if (!capturesOnly) {
-            // Up/down one
-            uint64_t s1 = shiftFunc(sftBoard);
-            if (s1 & friendly & enemy) {
-                newpos = __builtin_ctzll(s1);
-                // Promotion
-                if ((newpos / 8 == 0) || (newpos / 8 == 7)) {
-                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, QUEEN);
-                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, KNIGHT);
-                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, ROOK);
-                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, BISHOP);
-                    numMoves += 4;
-                } else {
-                    *(moves++) = Move(pos, newpos);
-                    numMoves++;
-                    // Move up 2
-                    if ((pos / 8 == 1 && turn == WHITE) 
-                        || (pos / 8 == 6 && turn == BLACK)) 
-                    {
-                        s1 = shiftFunc(s1);
-                        newpos = __builtin_ctzll(s1);
-                        if (s1 & friendly & enemy) {
-                            *(moves++) = Move(pos, newpos);
-                            numMoves++;
-                        }
-                    }
-                }
-            }
-        }
-
-        // Kill adjacent piece
-        uint64_t attacks = pawnAttacks[turn][pos];
-        attacks &= (~enemy | ep);
-        while (attacks) {
-            uint64_t m = attacks & -attacks;
-            newpos = __builtin_ctzll(m);
-            if (newpos / 8 == 0 || newpos / 8 == 7) {
-                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, QUEEN);
-                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, KNIGHT);
-                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, ROOK);
-                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, BISHOP);
-                numMoves += 4;
-            } else {
-                *(moves++) = Move(pos, newpos, (m & ep) ? EN_PASSANT_MOVE : CAPTURE_MOVE);
-                numMoves++;
-            }
-            attacks &= attacks - 1;
-        }
-
-        // Move onto the next pawn
-        bb &= bb - 1;
-    }
-    return numMoves;
-}
-
-uint32_t BitBoard::getKingMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const {
-    uint64_t bb = p[turn].king;
-    uint8_t pos, newpos;
-    uint32_t numMoves = 0;
-    uint64_t friendly = ~s[turn].occupancy;
-    uint64_t enemy = ~s[!turn].occupancy;
-    pos = __builtin_ctzll(bb);
-
-    if (!capturesOnly) {
-        // Castling
-        if (s[turn].castleShort) {
-            uint64_t sftBoard = bb;
-            maskIfPositionAttacked(sftBoard, turn);
-            sftBoard = shiftEast(sftBoard);
-            sftBoard &= friendly & enemy;
-            if (sftBoard) maskIfPositionAttacked(sftBoard, turn);
-            sftBoard = shiftEast(sftBoard);
-            sftBoard &= friendly & enemy;
-            if (sftBoard) maskIfPositionAttacked(sftBoard, turn);
-            if (sftBoard) {
-                newpos = __builtin_ctzll(sftBoard);
-                *(moves++) = Move(pos, newpos, CASTLE_MOVE);
-                numMoves++;
-            }
-        }
-        if (s[turn].castleLong) {
-            uint64_t sftBoard = bb;
-            maskIfPositionAttacked(sftBoard, turn);
-            sftBoard = shiftWest(sftBoard);
-            sftBoard &= friendly & enemy;
-            if (sftBoard) maskIfPositionAttacked(sftBoard, turn);
-            sftBoard = shiftWest(sftBoard);
-            sftBoard &= friendly & enemy;
-            if (sftBoard) maskIfPositionAttacked(sftBoard, turn);
-            newpos = __builtin_ctzll(sftBoard);
-            sftBoard = shiftWest(sftBoard);
-            sftBoard &= friendly & enemy;
-            if (sftBoard) {
-                *(moves++) = Move(pos, newpos, CASTLE_MOVE);
-                numMoves++;
-            }
-        }
-    }
-
-    uint64_t attacks = kingAttacks[pos];
-    attacks &= friendly;
-    if (capturesOnly) attacks &= ~enemy;
-    while (attacks) {
-        uint64_t m = attacks & -attacks;
-        newpos = __builtin_ctzll(m);
-        *(moves++) = Move(pos, newpos, (m & ~enemy) ? CAPTURE_MOVE : DEFAULT_MOVE);
-        numMoves++;
-        attacks &= attacks - 1;
-    }
-
-    return numMoves;
-}
-
-uint32_t BitBoard::getKnightMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const {
-    uint8_t pos, newpos;
-    uint64_t bb = p[turn].knight;
-    uint32_t numMoves = 0;
-    uint64_t friendly = ~s[turn].occupancy;
-    uint64_t enemy = ~s[!turn].occupancy;
-
-    while (bb) {
-        // Isolate the least significant bit and find it
-        uint64_t sftBoard = bb & -bb;
-        pos = __builtin_ctzll(sftBoard);
-        uint64_t attacks = knightAttacks[pos];
-        attacks &= friendly;
-        if (capturesOnly) attacks &= s[!turn].occupancy;
-        while (attacks) {
-            uint64_t m = attacks & -attacks;
-            newpos = __builtin_ctzll(m);
-            *(moves++) = Move(pos, newpos, (m & ~enemy) ? CAPTURE_MOVE : DEFAULT_MOVE);
-            numMoves++;
-            attacks &= attacks - 1;
-        }
-        // Clear last least significant bit
-        bb &= bb - 1;
-    }
-    return numMoves;
-}
-
-uint32_t BitBoard::getRookMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const {
-    uint64_t bb = p[turn].rook | p[turn].queen;
-    uint32_t numMoves = 0;
-    numMoves += searchStraight(bb, &shiftNorth, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftSouth, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftWest, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftEast, moves, capturesOnly);
-    return numMoves;
-}
-
-uint32_t BitBoard::getBishopMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const {
-    uint64_t bb = p[turn].bishop | p[turn].queen;
-    uint32_t numMoves = 0;
-    numMoves += searchStraight(bb, &shiftNoEast, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftNoWest, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftSoEast, moves, capturesOnly);
-    numMoves += searchStraight(bb, &shiftSoWest, moves, capturesOnly);
-    return numMoves;
-}
-
-uint8_t BitBoard::getAvailableMoves(std::array<Move,MAX_MOVES>& movesAvailable, bool capturesOnly) const {
-    std::array<Move,MAX_MOVES>::iterator moves = movesAvailable.begin();
-    uint32_t numMoves = 0;
-
-    numMoves += getPawnMoves(moves, capturesOnly);
-    numMoves += getKingMoves(moves, capturesOnly);
-    numMoves += getKnightMoves(moves, capturesOnly);
-    numMoves += getRookMoves(moves, capturesOnly);
-    numMoves += getBishopMoves(moves, capturesOnly);
-
-    assert(moves < movesAvailable.end());
-    return numMoves;
-}
-
-bool BitBoard::testInCheck(bool c) const {
-    uint64_t king = p[c].king;
-    maskIfPositionAttacked(king, c);
-    return !king;
-}
-
-int32_t BitBoard::evaluateKingSafety() const {
-    int32_t numPos = 0;
-    // King safety. Pretend king was a queen and see how far it can go. Penalize more available moves.
-    numPos = 0;
-    uint64_t occupied = ~(s[turn].occupancy | s[!turn].occupancy);
-
-    auto slidingFuncs = {&shiftNorth, &shiftEast, &shiftSouth, &shiftWest, &shiftNoEast, &shiftNoWest, &shiftSoEast, &shiftSoWest};
-    for (auto func : slidingFuncs) {
-        uint64_t sft = p[turn].king;
-        while (sft) {
-            sft = func(sft);
-            sft &= occupied;
-            if (sft) numPos++;
-        }
-    }
-
-    return numPos;
-}
-
-int32_t BitBoard::estimateMoveValue(Move const& move) const {
-    static constexpr int32_t CAPTURE_BONUS = 75;
-    static constexpr int32_t CASTLE_BONUS = 100;
-
-    int32_t value = 0;
-    uint64_t to_bb = 1ull << move.to;
-    bool target_defended = s[!turn].mobility & to_bb;
-
-    value += move.moveData.isCapture * CAPTURE_BONUS;
-    value += move.moveData.isCastle * CASTLE_BONUS;
-    value += move.moveData.isEnPassant * PAWN_VALUE_MG;
-
-    // Benefit to put our piece on a good square
-    value += pstDelta(move);
-    
-    // Most valuable target, least valuable attacker. Don't care about attacker if target is not defended
-    value += getPieceValue(getPiece(p[!turn], move.to));
-    value -= target_defended * getPieceValue(getPiece(p[turn], move.from));
-    
-    value += getPieceValue(move.promote);
-
-    return value;
-}
-
-inline int32_t BitBoard::pstDelta(Move const& move) const {
-    enum Piece source = getPiece(p[turn], move.from);
-    int32_t pst;
-    uint8_t from = move.from;
-    uint8_t to = move.to;
-    if (!turn) {
-        uint8_t col = to % 8;
-        uint8_t row = 7 - (to / 8);
-        to = (row * 8 + col);
-
-        col = from % 8;
-        row = 7 - (from / 8);
-        from = (row * 8 + col);
-    }
-
-    float egBlend = calculateEndgameBlendFactor();
-    float mgBlend = 1-egBlend;
-
-    switch (source) {
-        case PAWN:
-            pst = mgBlend*(PST_MG_P[to]-PST_MG_P[from]) + egBlend*(PST_EG_P[to]-PST_EG_P[from]);
-            break;
-        case KNIGHT:
-            pst = mgBlend*(PST_MG_N[to]-PST_MG_N[from]) + egBlend*(PST_EG_N[to]-PST_EG_N[from]);
-            break;
-        case BISHOP:
-            pst = mgBlend*(PST_MG_B[to]-PST_MG_B[from]) + egBlend*(PST_EG_B[to]-PST_EG_B[from]);
-            break;
-        case ROOK:
-            pst = mgBlend*(PST_MG_R[to]-PST_MG_R[from]) + egBlend*(PST_EG_R[to]-PST_EG_R[from]);
-            break;
-        case QUEEN:
-            pst = mgBlend*(PST_MG_Q[to]-PST_MG_Q[from]) + egBlend*(PST_EG_Q[to]-PST_EG_Q[from]);
-            break;
-        case KING:
-            pst = mgBlend*(PST_MG_K[to]-PST_MG_K[from]) + egBlend*(PST_EG_K[to]-PST_EG_K[from]);
-            break;
-        default:
-            assert(0);
-
-    }
-
-    return Evaluate::PST_FACTOR * pst;
-}
-
-float BitBoard::calculateEndgameBlendFactor() const {
-    uint32_t material = 0;
-    static constexpr uint32_t maxMaterial = QUEEN_VALUE_MG + (2*KNIGHT_VALUE_MG) + (2*BISHOP_VALUE_MG) + (2*ROOK_VALUE_MG);
-    static constexpr uint32_t egCutoff = QUEEN_VALUE_MG - PAWN_VALUE_MG;
-
-    // Only count opponents non-pawn material
-    material += __builtin_popcountll(p[!turn].queen) * QUEEN_VALUE_MG;
-    material += __builtin_popcountll(p[!turn].knight) * KNIGHT_VALUE_MG;
-    material += __builtin_popcountll(p[!turn].bishop) * BISHOP_VALUE_MG;
-    material += __builtin_popcountll(p[!turn].rook) * ROOK_VALUE_MG;
-
-    if (material <= egCutoff) return 1;
-
-    return 1 - (static_cast<float>(material - egCutoff) / static_cast<float>(maxMaterial - egCutoff));
-}
-
-void BitBoard::sortMoves(std::array<Move,MAX_MOVES>& moves,
-                                uint8_t numMoves, Move const& ttMove) const 
-{
-    for (uint8_t i = 0; i < numMoves; i++) {
-        moves[i].value = estimateMoveValue(moves[i]);
-        if (moves[i] == ttMove) moves[i].value += 10000;
-        #ifdef HISTORY_HEURISTIC
-        moves[i].value += tt->getHistoryScore(turn, moves[i]);
-        #endif
-    }
-    std::sort(moves.begin(), moves.begin() + numMoves,
-            [&] (Move m1, Move m2) { return m1.value > m2.value; });
+#include "bitboard.hpp"
+#include "attacks.hpp"
+#include "evaluate.hpp"
+#include "transpositionTables.hpp"
+
+using namespace BitBoardState;
+
+inline uint64_t shiftNorth(uint64_t const b) { return b << 8; }
+inline uint64_t shiftSouth(uint64_t const b) { return b >> 8; }
+
+inline uint64_t shiftEast(uint64_t const b) {return (b << 1) & notAFile;}
+inline uint64_t shiftNoEast(uint64_t const b) {return (b << 9) & notAFile;}
+inline uint64_t shiftSoEast(uint64_t const b) {return (b >> 7) & notAFile;}
+inline uint64_t shiftWest(uint64_t const b) {return (b >> 1) & notHFile;}
+inline uint64_t shiftSoWest(uint64_t const b) {return (b >> 9) & notHFile;}
+inline uint64_t shiftNoWest(uint64_t const b) {return (b << 7) & notHFile;}
+
+// Material and piece-square values per colour, piece and square. Black's
+// squares are mirrored up front so lookups don't have to.
+struct PieceSquareScores {
+    BitBoard::Score s[2][7][64];
+};
+
+static constexpr PieceSquareScores generatePieceSquareScores() {
+    PieceSquareScores t = {};
+    for (uint8_t c = WHITE; c <= BLACK; c++) {
+        for (uint8_t piece = PAWN; piece <= KING; piece++) {
+            for (uint8_t pos = 0; pos < 64; pos++) {
+                // Tables are written from white's point of view with rank 8 first
+                uint8_t sq = c ? pos : pos ^ 56;
+                t.s[c][piece][pos] = {.materialMg=static_cast<int16_t>(PIECE_VALUE_MG[piece]),
+                                      .materialEg=static_cast<int16_t>(PIECE_VALUE_EG[piece]),
+                                      .pstMg=static_cast<int16_t>(PST_MG[piece][sq]),
+                                      .pstEg=static_cast<int16_t>(PST_EG[piece][sq])};
+            }
+        }
+    }
+    return t;
+}
+
+alignas(64) static constexpr PieceSquareScores PSQ = generatePieceSquareScores();
+
+BitBoard::BitBoard(TT* _tt, bool startpos) {
+    tt = _tt;
+
+    moves = 0;
+    if (startpos) {
+        p[0] = {.pawn=0xff00,.knight=0x42,.bishop=0x24,.rook=0x81,.queen=0x8,.king=0x10};
+        p[1] = {.pawn=0xff000000000000ull,.knight=0x4200000000000000ull,
+                .bishop=0x2400000000000000ull,.rook=0x8100000000000000ull,
+                .queen=0x800000000000000ull,.king=0x1000000000000000ull};
+
+        s[0] = s[1] = {.occupancy=0,.enPassantSquare=0,
+                        .castleShort=true,.castleLong=true};
+    } else {
+        p[0] = p[1] = {.pawn=0,.knight=0,.bishop=0,.rook=0,.queen=0,.king=0};
+        s[0] = s[1] = {.occupancy=0,.enPassantSquare=0,
+                        .castleShort=false,.castleLong=false};
+    }
+
+    turn = WHITE;
+    recalculateMailbox();
+    recalculateScore();
+    if (tt) {
+        recalculateKeys();
+    }
+
+    recalculateOccupancy();
+    threatsValid = false;
+}
+
+void BitBoard::recalculateOccupancy() {
+    for (uint8_t turn = WHITE; turn <= BLACK; turn++) {
+        s[turn].occupancy = p[turn].pawn | p[turn].bishop 
+                                        | p[turn].knight | p[turn].rook
+                                        | p[turn].queen | p[turn].king;
+    }
+
+    assert((s[0].occupancy ^ s[1].occupancy) 
+            == (s[0].occupancy | s[1].occupancy));
+}
+
+void BitBoard::recalculateMailbox() {
+    for (uint8_t pos = 0; pos < 64; pos++) {
+        pieceOn[pos] = static_cast<Piece>(getPiece(p[WHITE], pos) | getPiece(p[BLACK], pos));
+    }
+}
+
+void BitBoard::recalculateKeys() {
+    hash = tt->genHash(*this);
+    pawnKey = tt->genPawnKey(*this);
+    materialKey = tt->genMaterialKey(*this);
+    nonPawnKey[WHITE] = tt->genNonPawnKey(*this, WHITE);
+    nonPawnKey[BLACK] = tt->genNonPawnKey(*this, BLACK);
+}
+
+void BitBoard::recalculateScore() {
+    score[WHITE] = score[BLACK] = {.materialMg=0, .materialEg=0, .pstMg=0, .pstEg=0};
+    for (uint8_t c = WHITE; c <= BLACK; c++) {
+        uint64_t pieces = p[c].pawn | p[c].knight | p[c].bishop | p[c].rook | p[c].queen | p[c].king;
+        while (pieces) {
+            uint8_t pos = __builtin_ctzll(pieces);
+            updateScore(pieceOn[pos], c, pos, 1);
+            pieces &= pieces - 1;
+        }
+    }
+}
+
+void BitBoard::recalculateThreats() const {
+    for (uint8_t c = WHITE; c <= BLACK; c++) {
+        t[c].mobility = 0;
+        t[c].scope = 0;
+        uint64_t friendly = ~s[c].occupancy;
+        uint64_t enemy = ~s[!c].occupancy;
+
+        uint64_t sliding = p[c].rook | p[c].queen;
+        uint64_t angle = p[c].bishop | p[c].queen;
+
+        uint64_t bb = p[c].knight;
+        while (bb) {
+            // Isolate the least significant bit and find it
+            uint8_t pos = __builtin_ctzll(bb);
+            uint64_t attacks = Attacks::knightAttacks(pos);
+            t[c].mobility |= attacks;
+            // Clear last least significant bit
+            t[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
+            bb &= bb - 1;
+        }
+
+        bb = p[c].king;
+        while (bb) {
+            uint8_t pos = __builtin_ctzll(bb);
+            uint64_t attacks = Attacks::kingAttacks(pos);
+            t[c].mobility |= attacks;
+            t[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
+            bb &= bb - 1;
+        }
+
+        bb = p[c].pawn;
+        while (bb) {
+            uint8_t pos = __builtin_ctzll(bb);
+            uint64_t attacks = Attacks::pawnAttacks(c, pos);
+            t[c].mobility |= attacks;
+            t[c].scope += __builtin_popcountll(attacks & (~enemy | ~friendly));
+            bb &= bb - 1;
+        }
+
+        uint64_t occupied = s[c].occupancy | s[!c].occupancy;
+
+        #ifdef USE_AVX2
+        // All sliders at once, a piece's blockers are only counted in its own direction
+        uint64_t attacks[8];
+        Attacks::slidingAttacks(sliding, angle, ~occupied, attacks);
+        for (uint64_t a : attacks) {
+            t[c].mobility |= a;
+            t[c].scope += __builtin_popcountll(a & occupied);
+        }
+        #else
+        bb = sliding;
+        while (bb) {
+            uint8_t pos = __builtin_ctzll(bb);
+            uint64_t attacks = Attacks::rookAttacks(pos, occupied);
+            t[c].mobility |= attacks;
+            t[c].scope += __builtin_popcountll(attacks & occupied);
+            bb &= bb - 1;
+        }
+
+        bb = angle;
+        while (bb) {
+            uint8_t pos = __builtin_ctzll(bb);
+            uint64_t attacks = Attacks::bishopAttacks(pos, occupied);
+            t[c].mobility |= attacks;
+            t[c].scope += __builtin_popcountll(attacks & occupied);
+            bb &= bb - 1;
+        }
+        #endif
+    }
+    threatsValid = true;
+}
+
+int32_t BitBoard::getPieceValue(Piece const& piece) const
+{
+    int32_t value;
+    bool isEndgame = moves > ENDGAME_CUTOFF;
+    switch(piece) {
+        case PAWN:
+            value = isEndgame ? PAWN_VALUE_EG : PAWN_VALUE_MG;
+            break;
+        case KNIGHT:
+            value = isEndgame ? KNIGHT_VALUE_EG : KNIGHT_VALUE_MG;
+            break;
+        case BISHOP:
+            value = isEndgame ? BISHOP_VALUE_EG : BISHOP_VALUE_MG;
+            break;
+        case ROOK:
+            value = isEndgame ? ROOK_VALUE_EG : ROOK_VALUE_MG;
+            break;
+        case QUEEN:
+            value = isEndgame ? QUEEN_VALUE_EG : QUEEN_VALUE_MG;
+            break;
+        case KING:
+            value = KING_STRENGTH_VALUE;
+            break;
+        case EMPTY:
+            value = 0;
+            break;
+        default:
+            assert(0);
+    }
+    return value;
+}
+
+enum Piece BitBoard::getPiece(struct Pieces const& p, uint8_t pos) const
+{
+    return ((p.pawn >> pos) & 0x1) ? PAWN :
+            ((p.knight >> pos) & 0x1) ? KNIGHT :
+            ((p.bishop >> pos) & 0x1) ? BISHOP :
+            ((p.rook >> pos) & 0x1) ? ROOK :
+            ((p.king >> pos) & 0x1) ? KING :
+            ((p.queen >> pos) & 0x1) ? QUEEN : EMPTY;
+}
+
+void BitBoard::maskClearBitBoard(enum Piece piece, bool c, uint64_t m) {
+    struct Pieces& bitboard = p[c];
+    switch(piece) {
+        case PAWN:
+            bitboard.pawn &= ~m;
+            break;
+        case KNIGHT:
+            bitboard.knight &= ~m;
+            break;
+        case BISHOP:
+            bitboard.bishop &= ~m;
+            break;
+        case ROOK:
+            bitboard.rook &= ~m;
+            break;
+        case KING:
+            bitboard.king &= ~m;
+            break;
+        case QUEEN:
+            bitboard.queen &= ~m;
+            break;
+        default:
+            break;
+    }
+    uint8_t pos = __builtin_ctzll(m);
+    if (piece) updateScore(piece, c, pos, -1);
+    pieceOn[pos] = EMPTY;
+}
+
+inline void BitBoard::updateScore(enum Piece piece, bool c, uint8_t pos, int8_t sign) {
+    Score const& delta = PSQ.s[c][piece][pos];
+    score[c].materialMg += sign * delta.materialMg;
+    score[c].materialEg += sign * delta.materialEg;
+    score[c].pstMg += sign * delta.pstMg;
+    score[c].pstEg += sign * delta.pstEg;
+}
+
+void BitBoard::maskSetBitBoard(enum Piece piece, bool c, uint64_t m) {
+    struct Pieces& bitboard = p[c];
+    switch(piece) {
+        case PAWN:
+            bitboard.pawn |= m;
+            break;
+        case KNIGHT:
+            bitboard.knight |= m;
+            break;
+        case BISHOP:
+            bitboard.bishop |= m;
+            break;
+        case ROOK:
+            bitboard.rook |= m;
+            break;
+        case KING:
+            bitboard.king |= m;
+            break;
+        case QUEEN:
+            bitboard.queen |= m;
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    uint8_t pos = __builtin_ctzll(m);
+    updateScore(piece, c, pos, 1);
+    pieceOn[pos] = piece;
+}
+
+void BitBoard::changeTurn() {
+    hash ^= TURN_HASH_WHITE;
+    turn = static_cast<Color>(turn ^ BLACK); // BLACK == 1
+}
+
+void BitBoard::strToMove(std::string const& moveText, struct Move& move) {
+    assert(moveText.size() == 4 || moveText.size() == 5);
+
+    uint8_t col = moveText[0] - 'a';
+    uint8_t row = moveText[1] - '0' - 1;
+    uint8_t from = (row<<3) | col;
+    assert(from < 64);
+
+    col = moveText[2] - 'a';
+    row = moveText[3] - '0' - 1;
+    uint8_t to = (row<<3) | col;
+    assert(to < 64);
+
+    Piece promote = EMPTY;
+    if (moveText.size() == 5) {
+        switch(moveText[4]) {
+            case 'n':
+                promote = KNIGHT;
+                break;
+            case 'b':
+                promote = BISHOP;
+                break;
+            case 'r':
+                promote = ROOK;
+                break;
+            case 'q':
+                promote = QUEEN;
+                break;
+            default:
+                assert(0);
+        }
+    }
+    move = Move(from, to, (promote != EMPTY) ? PROMOTION_MOVE : DEFAULT_MOVE, promote);
+}
+
+std::string BitBoard::moveToStr(struct Move const& move) {
+    char colF = 'a' + (move.from() & 7);
+    char rowF = '1' + (move.from() >> 3);
+    char colT = 'a' + (move.to() & 7);
+    char rowT = '1' + (move.to() >> 3);
+    std::string moveStr;
+    moveStr.append(1, colF);
+    moveStr.append(1, rowF);
+    moveStr.append(1, colT);
+    moveStr.append(1, rowT);
+    if (move.promote() != EMPTY) {
+        switch(move.promote()) {
+            case KNIGHT:
+                moveStr.append(1, 'n');
+                break;
+            case BISHOP:
+                moveStr.append(1, 'b');
+                break;
+            case ROOK:
+                moveStr.append(1, 'r');
+                break;
+            case QUEEN:
+                moveStr.append(1, 'q');
+                break;
+            default:
+                assert(0);
+        }
+    }
+    return moveStr;
+}
+std::string BitBoard::pieceToUnicode(enum Piece piece, enum Color c) const {
+    std::string pieceChar = "?";
+    if (c == WHITE) {
+        switch(piece) {
+            case EMPTY:
+                pieceChar = ".";
+                break;
+            case PAWN:
+                pieceChar = "\u265f";
+                break;
+            case ROOK:
+                pieceChar = "\u265c";
+                break;
+            case BISHOP:
+                pieceChar = "\u265d";
+                break;
+            case KNIGHT:
+                pieceChar = "\u265e";
+                break;
+            case KING:
+                pieceChar = "\u265a";
+                break;
+            case QUEEN:
+                pieceChar = "\u265b";
+                break;
+            default:
+                assert(0);
+                break;
+        }
+    } else if (c == BLACK) {
+        switch(piece) {
+            case EMPTY:
+                pieceChar = ".";
+                break;
+            case PAWN:
+                pieceChar = "\u2659";
+                break;
+            case ROOK:
+                pieceChar = "\u2656";
+                break;
+            case BISHOP:
+                pieceChar = "\u2657";
+                break;
+            case KNIGHT:
+                pieceChar = "\u2658";
+                break;
+            case KING:
+                pieceChar = "\u2654";
+                break;
+            case QUEEN:
+                pieceChar = "\u2655";
+                break;
+            default:
+                assert(0);
+                break;
+        }
+    }
+    return pieceChar;
+}
+
+int32_t BitBoard::getBoardValue() const {
+    bool isEndgame = moves > ENDGAME_CUTOFF;
+    return isEndgame ? score[turn].materialEg - score[!turn].materialEg
+                     : score[turn].materialMg - score[!turn].materialMg;
+}
+
+void BitBoard::printBoard() const {
+    std::cout << std::endl;
+    for (uint8_t row = 8; row > 0; row--) {
+        std::cout << std::to_string(row) << " ";
+        for (uint8_t col = 0; col < 8; col++) {
+            uint8_t pos = ((row-1)<<3) | col;
+            enum Piece piece = pieceOn[pos];
+            Color turn = ((s[0].occupancy >> pos) & 0x1) ? WHITE : BLACK;
+            std::cout << pieceToUnicode(piece, turn) << " ";
+        }
+        std::cout << std::endl;
+    }
+    
+    std::cout << "* ";
+    for (uint8_t col = 0; col < 8; col++) {
+        char colChar = 'a' + col;
+        std::cout << colChar << " ";
+    }
+    std::cout << std::endl;
+    std::cout << "Material Imbalance: " << std::to_string(getBoardValue()) << std::endl;
+    std::cout << "Turn: " << (turn == WHITE ? "White" : "Black") << std::endl;
+    std::cout << "Board hash: 0x" << std::hex << hash << std::endl;
+}
+
+void BitBoard::printMobility() const {
+    for (uint8_t c = WHITE; c <= BLACK; c++) {
+        Threats const& threats = getThreats(c);
+        std::cout << "Mobility[" << (c == WHITE ? "white" : "black") << "]: 0x" << std::hex << threats.mobility << std::endl;
+        std::cout << "Scope[" << (c == WHITE ? "white" : "black") << "]: " << std::dec << threats.scope << std::endl;
+        std::cout << "Occupancy[" << (c == WHITE ? "white" : "black") << "]: 0x" << std::hex << s[c].occupancy << std::endl;
+
+        for (uint8_t row = 8; row > 0; row--) {
+            std::cout << std::to_string(row) << " ";
+            for (uint8_t col = 0; col < 8; col++) {
+                uint8_t pos = ((row-1)<<3) | col;
+                std::cout << (((threats.mobility >> pos) & 0x1) ? "X" : " ") << " ";
+            }
+            std::cout << std::endl;
+        }
+        
+        std::cout << "* ";
+        for (uint8_t col = 0; col < 8; col++) {
+            char colChar = 'a' + col;
+            std::cout << colChar << " ";
+        }
+        std::cout << std::endl;
+        std::cout << std::endl;
+    }
+}
+
+void BitBoard::validateBitBoard() const {
+    #ifdef ASSERT_ON
+    assert((hash == tt->genHash(*this)));
+    assert((pawnKey == tt->genPawnKey(*this)));
+    assert((materialKey == tt->genMaterialKey(*this)));
+    assert((nonPawnKey[WHITE] == tt->genNonPawnKey(*this, WHITE)));
+    assert((nonPawnKey[BLACK] == tt->genNonPawnKey(*this, BLACK)));
+    for (uint8_t pos = 0; pos < 64; pos++) {
+        assert(pieceOn[pos] == (getPiece(p[WHITE], pos) | getPiece(p[BLACK], pos)));
+    }
+    BitBoard fresh = *this;
+    fresh.recalculateScore();
+    for (uint8_t c = WHITE; c <= BLACK; c++) {
+        assert(fresh.score[c].materialMg == score[c].materialMg && fresh.score[c].materialEg == score[c].materialEg);
+        assert(fresh.score[c].pstMg == score[c].pstMg && fresh.score[c].pstEg == score[c].pstEg);
+    }
+    #endif
+}
+
+// Call after the piece has been set or cleared on pos. The material key hashes
+// each piece count, the n-th piece of a type using BOARDPOS_HASH[c][piece][n].
+inline void BitBoard::updateKeys(enum Piece piece, bool c, uint8_t pos, bool added) {
+    uint64_t const* bb[7] = {nullptr, &p[c].pawn, &p[c].rook, &p[c].knight, &p[c].bishop, &p[c].queen, &p[c].king};
+    uint8_t count = __builtin_popcountll(*bb[piece]) - added;
+    materialKey ^= tt->BOARDPOS_HASH[c][piece][count];
+    if (piece == PAWN || piece == KING) pawnKey ^= tt->BOARDPOS_HASH[c][piece][pos];
+    if (piece != PAWN) nonPawnKey[c] ^= tt->BOARDPOS_HASH[c][piece][pos];
+}
+
+void BitBoard::movePiece(struct Move const& move) {
+    if (turn == WHITE) movePiece<WHITE>(move);
+    else movePiece<BLACK>(move);
+}
+
+template<Color Us>
+void BitBoard::movePiece(struct Move const& move) {
+    constexpr Color Them = static_cast<Color>(!Us);
+    constexpr int8_t up = (Us == WHITE) ? 8 : -8;
+    constexpr uint8_t ourRookShort = (Us == WHITE) ? 7 : 63;
+    constexpr uint8_t ourRookLong = (Us == WHITE) ? 0 : 56;
+    constexpr uint8_t theirRookShort = (Us == WHITE) ? 63 : 7;
+    constexpr uint8_t theirRookLong = (Us == WHITE) ? 56 : 0;
+    constexpr uint64_t ourShortHash = (Us == WHITE) ? WHITE_CASTLE_SHORT_HASH : BLACK_CASTLE_SHORT_HASH;
+    constexpr uint64_t ourLongHash = (Us == WHITE) ? WHITE_CASTLE_LONG_HASH : BLACK_CASTLE_LONG_HASH;
+    constexpr uint64_t theirShortHash = (Us == WHITE) ? BLACK_CASTLE_SHORT_HASH : WHITE_CASTLE_SHORT_HASH;
+    constexpr uint64_t theirLongHash = (Us == WHITE) ? BLACK_CASTLE_LONG_HASH : WHITE_CASTLE_LONG_HASH;
+
+    uint8_t from = move.from();
+    uint8_t to = move.to();
+    uint64_t fromBitboard = 1ull << from;
+    uint64_t toBitboard = 1ull << to;
+
+    enum Piece fromPiece = pieceOn[from];
+    enum Piece toPiece = pieceOn[to];
+
+    hash ^= tt->BOARDPOS_HASH[Us][fromPiece][from];
+    if (toPiece) hash ^= tt->BOARDPOS_HASH[Them][toPiece][to];
+
+    maskClearBitBoard(fromPiece, Us, fromBitboard);
+    maskClearBitBoard(toPiece, Them, toBitboard);
+    updateKeys(fromPiece, Us, from, false);
+    if (toPiece) updateKeys(toPiece, Them, to, false);
+
+    // Promote
+    if (move.promote() != EMPTY) {
+        fromPiece = move.promote();
+    }
+    
+    hash ^= tt->BOARDPOS_HASH[Us][fromPiece][to];
+    maskSetBitBoard(fromPiece, Us, toBitboard);
+    updateKeys(fromPiece, Us, to, true);
+
+    // En Passant, the captured pawn is behind the target square
+    if (fromPiece == PAWN && s[Us].enPassantSquare != 0 && s[Us].enPassantSquare == to) {
+        maskClearBitBoard(PAWN, Them, 1ull << (to - up));
+        hash ^= tt->BOARDPOS_HASH[Them][PAWN][to - up];
+        updateKeys(PAWN, Them, to - up, false);
+    }
+
+    hash ^= EN_PASSANT_HASH*s[Us].enPassantSquare;
+    s[Us].enPassantSquare = 0;
+    if (fromPiece == PAWN && to - from == 2*up) {
+        s[Them].enPassantSquare = from + up;
+    }
+    hash ^= EN_PASSANT_HASH*s[Them].enPassantSquare;
+
+    // Castling
+    if (fromPiece == KING && s[Us].castleShort && to-from == 2) {
+        if (s[Us].castleShort) hash ^= ourShortHash;
+        if (s[Us].castleLong) hash ^= ourLongHash;
+        s[Us].castleShort = false;
+        s[Us].castleLong = false;
+
+        maskClearBitBoard(ROOK, Us, toBitboard<<1ull);
+        maskSetBitBoard(ROOK, Us, toBitboard>>1ull);
+        hash ^= tt->BOARDPOS_HASH[Us][ROOK][to-1];
+        hash ^= tt->BOARDPOS_HASH[Us][ROOK][to+1];
+        nonPawnKey[Us] ^= tt->BOARDPOS_HASH[Us][ROOK][to-1] ^ tt->BOARDPOS_HASH[Us][ROOK][to+1];
+    } else if (fromPiece == KING && s[Us].castleLong && from-to == 2) {
+        if (s[Us].castleShort) hash ^= ourShortHash;
+        if (s[Us].castleLong) hash ^= ourLongHash;
+        s[Us].castleShort = false;
+        s[Us].castleLong = false;
+
+        maskClearBitBoard(ROOK, Us, toBitboard>>2ull);
+        maskSetBitBoard(ROOK, Us, toBitboard<<1ull);
+        hash ^= tt->BOARDPOS_HASH[Us][ROOK][to-2];
+        hash ^= tt->BOARDPOS_HASH[Us][ROOK][to+1];
+        nonPawnKey[Us] ^= tt->BOARDPOS_HASH[Us][ROOK][to-2] ^ tt->BOARDPOS_HASH[Us][ROOK][to+1];
+    } 
+
+    // Can no longer castle because moved king or rook:
+    else if (fromPiece == KING) {
+        if (s[Us].castleShort) hash ^= ourShortHash;
+        if (s[Us].castleLong) hash ^= ourLongHash;
+        s[Us].castleShort = false;
+        s[Us].castleLong = false;
+    } else if (s[Us].castleShort && fromPiece == ROOK && from == ourRookShort) {
+        s[Us].castleShort = false;
+        hash ^= ourShortHash;
+    } else if (s[Us].castleLong && fromPiece == ROOK && from == ourRookLong) {
+        s[Us].castleLong = false;
+        hash ^= ourLongHash;
+    }
+
+    // Can no longer castle becaue our rook was captured
+    if (s[Them].castleShort && toPiece == ROOK && to == theirRookShort) {
+        s[Them].castleShort = false;
+        hash ^= theirShortHash;
+    } else if (s[Them].castleLong && toPiece == ROOK && to == theirRookLong) {
+        s[Them].castleLong = false;
+        hash ^= theirLongHash;
+    }
+
+    changeTurn();
+    moves++;
+
+    recalculateOccupancy();
+    threatsValid = false;
+    validateBitBoard();
+}
+
+void BitBoard::makeMove(struct Move const& move, UndoInfo& undo) {
+    undo.s[WHITE] = s[WHITE];
+    undo.s[BLACK] = s[BLACK];
+    undo.threatsValid = threatsValid;
+    if (threatsValid) {
+        undo.t[WHITE] = t[WHITE];
+        undo.t[BLACK] = t[BLACK];
+    }
+    undo.hash = hash;
+    undo.pawnKey = pawnKey;
+    undo.materialKey = materialKey;
+    undo.nonPawnKey[WHITE] = nonPawnKey[WHITE];
+    undo.nonPawnKey[BLACK] = nonPawnKey[BLACK];
+    undo.captured = pieceOn[move.to()];
+    movePiece(move);
+}
+
+void BitBoard::unmakeMove(struct Move const& move, UndoInfo const& undo) {
+    // The side that made the move is the one not to move now
+    if (turn == WHITE) unmakeMove<BLACK>(move, undo);
+    else unmakeMove<WHITE>(move, undo);
+}
+
+template<Color Us>
+void BitBoard::unmakeMove(struct Move const& move, UndoInfo const& undo) {
+    constexpr Color Them = static_cast<Color>(!Us);
+    constexpr int8_t up = (Us == WHITE) ? 8 : -8;
+
+    uint8_t from = move.from();
+    uint8_t to = move.to();
+    uint64_t fromBitboard = 1ull << from;
+    uint64_t toBitboard = 1ull << to;
+
+    turn = Us;
+    moves--;
+
+    enum Piece toPiece = pieceOn[to];
+    maskClearBitBoard(toPiece, Us, toBitboard);
+    enum Piece fromPiece = (move.promote() != EMPTY) ? PAWN : toPiece;
+    maskSetBitBoard(fromPiece, Us, fromBitboard);
+
+    if (undo.captured) {
+        maskSetBitBoard(undo.captured, Them, toBitboard);
+    }
+
+    // En Passant
+    if (fromPiece == PAWN && move.promote() == EMPTY 
+        && undo.s[Us].enPassantSquare != 0 && undo.s[Us].enPassantSquare == to) {
+        maskSetBitBoard(PAWN, Them, 1ull << (to - up));
+    }
+
+    // Castling, put the rook back
+    if (fromPiece == KING && undo.s[Us].castleShort && to-from == 2) {
+        maskClearBitBoard(ROOK, Us, toBitboard>>1ull);
+        maskSetBitBoard(ROOK, Us, toBitboard<<1ull);
+    } else if (fromPiece == KING && undo.s[Us].castleLong && from-to == 2) {
+        maskClearBitBoard(ROOK, Us, toBitboard<<1ull);
+        maskSetBitBoard(ROOK, Us, toBitboard>>2ull);
+    }
+
+    // Restores castling rights, en passant, occupancy and threats
+    s[WHITE] = undo.s[WHITE];
+    s[BLACK] = undo.s[BLACK];
+    threatsValid = undo.threatsValid;
+    if (threatsValid) {
+        t[WHITE] = undo.t[WHITE];
+        t[BLACK] = undo.t[BLACK];
+    }
+    hash = undo.hash;
+    pawnKey = undo.pawnKey;
+    materialKey = undo.materialKey;
+    nonPawnKey[WHITE] = undo.nonPawnKey[WHITE];
+    nonPawnKey[BLACK] = undo.nonPawnKey[BLACK];
+    validateBitBoard();
+}
+
+void BitBoard::makeNullMove(UndoInfo& undo) {
+    undo.s[WHITE] = s[WHITE];
+    undo.s[BLACK] = s[BLACK];
+    undo.hash = hash;
+    undo.captured = EMPTY;
+
+    // Threats don't depend on the side to move, so they stay valid
+    changeTurn();
+    hash ^= EN_PASSANT_HASH*s[turn].enPassantSquare;
+    hash ^= EN_PASSANT_HASH*s[!turn].enPassantSquare;
+    s[turn].enPassantSquare = 0;
+    s[!turn].enPassantSquare = 0;
+}
+
+void BitBoard::unmakeNullMove(UndoInfo const& undo) {
+    turn = static_cast<Color>(turn ^ BLACK);
+    s[WHITE] = undo.s[WHITE];
+    s[BLACK] = undo.s[BLACK];
+    hash = undo.hash;
+}
+
+bool BitBoard::isAvailable(uint8_t const pos) const {
+    return !((s[turn].occupancy >> pos) & 0x1);
+}
+
+bool BitBoard::isOccupied(uint8_t const pos) const {
+    return ((s[0].occupancy >> pos) & 0x1) || ((s[1].occupancy >> pos) & 0x1);
+}
+
+uint64_t BitBoard::attackersTo(uint8_t const sq, uint64_t const occupied) const {
+    return (Attacks::pawnAttacks(BLACK, sq) & p[WHITE].pawn)
+         | (Attacks::pawnAttacks(WHITE, sq) & p[BLACK].pawn)
+         | (Attacks::knightAttacks(sq) & (p[WHITE].knight | p[BLACK].knight))
+         | (Attacks::kingAttacks(sq) & (p[WHITE].king | p[BLACK].king))
+         | (Attacks::rookAttacks(sq, occupied) & (p[WHITE].rook | p[BLACK].rook | p[WHITE].queen | p[BLACK].queen))
+         | (Attacks::bishopAttacks(sq, occupied) & (p[WHITE].bishop | p[BLACK].bishop | p[WHITE].queen | p[BLACK].queen));
+}
+
+// Static exchange evaluation: material balance of the capture sequence on move.to(),
+// both sides always recapturing with their least valuable piece and free to stop.
+// Sliders behind the capturers are picked up as the square's attackers are removed.
+int32_t BitBoard::see(Move const& move) const {
+    static constexpr int32_t SEE_VALUE[7] = {0, PAWN_VALUE_MG, ROOK_VALUE_MG, KNIGHT_VALUE_MG,
+                                             BISHOP_VALUE_MG, QUEEN_VALUE_MG, KING_VALUE};
+    // Least valuable first
+    static constexpr Piece ORDER[6] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+
+    uint8_t to = move.to();
+    uint64_t fromBB = 1ull << move.from();
+    uint64_t occupied = s[WHITE].occupancy | s[BLACK].occupancy;
+    uint64_t diagonal = p[WHITE].bishop | p[BLACK].bishop | p[WHITE].queen | p[BLACK].queen;
+    uint64_t straight = p[WHITE].rook | p[BLACK].rook | p[WHITE].queen | p[BLACK].queen;
+
+    int32_t gain[32];
+    uint8_t d = 0;
+    Piece attacker = pieceOn[move.from()];
+
+    if (move.isEnPassant()) {
+        occupied ^= 1ull << (turn ? to + 8 : to - 8);
+        gain[0] = SEE_VALUE[PAWN];
+    } else {
+        gain[0] = SEE_VALUE[pieceOn[to]];
+    }
+    if (move.isPromotion()) {
+        attacker = move.promote();
+        gain[0] += SEE_VALUE[attacker] - SEE_VALUE[PAWN];
+    }
+
+    uint64_t attackers = attackersTo(to, occupied);
+    bool side = turn;
+
+    do {
+        d++;
+        // Speculative, only counts if the other side recaptures
+        gain[d] = SEE_VALUE[attacker] - gain[d-1];
+        if (std::max(-gain[d-1], gain[d]) < 0) break;
+
+        occupied ^= fromBB;
+        attackers |= (Attacks::bishopAttacks(to, occupied) & diagonal) | (Attacks::rookAttacks(to, occupied) & straight);
+        attackers &= occupied;
+        side = !side;
+
+        fromBB = 0;
+        uint64_t ours = attackers & s[side].occupancy;
+        for (Piece piece : ORDER) {
+            uint64_t bb = ours & (piece == PAWN ? p[side].pawn : piece == KNIGHT ? p[side].knight
+                                 : piece == BISHOP ? p[side].bishop : piece == ROOK ? p[side].rook
+                                 : piece == QUEEN ? p[side].queen : p[side].king);
+            if (bb) {
+                fromBB = bb & -bb;
+                attacker = piece;
+                break;
+            }
+        }
+    } while (fromBB && d < 31);
+
+    while (--d) {
+        gain[d-1] = -std::max(-gain[d-1], gain[d]);
+    }
+    return gain[0];
+}
+
+inline bool BitBoard::isAttacked(uint8_t const sq, bool c, uint64_t const occupied) const {
+    return attackersTo(sq, occupied) & s[!c].occupancy;
+}
+
+// Pieces of side owner that are the only thing between the king on ksq and
+// one of the sliders in snipers
+uint64_t BitBoard::sliderBlockers(uint8_t const ksq, uint64_t snipers, bool owner) const {
+    uint64_t occupied = s[WHITE].occupancy | s[BLACK].occupancy;
+    uint64_t blockers = 0;
+
+    // Only sliders that would see the king on an empty board
+    snipers &= (Attacks::rookAttacks(ksq, 0) & (p[WHITE].rook | p[BLACK].rook | p[WHITE].queen | p[BLACK].queen))
+             | (Attacks::bishopAttacks(ksq, 0) & (p[WHITE].bishop | p[BLACK].bishop | p[WHITE].queen | p[BLACK].queen));
+    while (snipers) {
+        uint64_t between = Attacks::between(ksq, __builtin_ctzll(snipers)) & occupied;
+        // Exactly one piece in between and it belongs to owner
+        if (between && !(between & (between - 1)) && (between & s[owner].occupancy)) {
+            blockers |= between;
+        }
+        snipers &= snipers - 1;
+    }
+    return blockers;
+}
+
+uint64_t BitBoard::pinnedPieces(bool c) const {
+    return sliderBlockers(__builtin_ctzll(p[c].king), s[!c].occupancy, c);
+}
+
+// Our pieces that give check by moving off the line between our slider and their king
+uint64_t BitBoard::discoveredCheckers(bool c) const {
+    return sliderBlockers(__builtin_ctzll(p[!c].king), s[c].occupancy, c);
+}
+
+template<Color Us>
+inline uint32_t BitBoard::getSlidingMoves(uint64_t bitboard, uint64_t attackFunc(uint8_t const sq, uint64_t const occ),
+                                          Move*& moves, MoveGenMasks const& masks) const
+{
+    constexpr Color Them = static_cast<Color>(!Us);
+    uint8_t pos, newpos;
+    uint32_t numMoves = 0;
+
+    uint64_t occupied = s[Us].occupancy | s[Them].occupancy;
+
+    while (bitboard) {
+        // Isolate the least significant bit and find it
+        pos = __builtin_ctzll(bitboard);
+        uint64_t attacks = attackFunc(pos, occupied) & masks.targets;
+        // Pinned pieces can only move along the pin
+        if (masks.pinned & (1ull << pos)) attacks &= Attacks::line(masks.kingSquare, pos);
+
+        while (attacks) {
+            uint64_t m = attacks & -attacks;
+            newpos = __builtin_ctzll(m);
+            *(moves++) = Move(pos, newpos, (m & s[Them].occupancy) ? CAPTURE_MOVE : DEFAULT_MOVE);
+            numMoves++;
+            attacks &= attacks - 1;
+        }
+        // Clear last least significant bit
+        bitboard &= bitboard - 1;
+    }
+    return numMoves;
+}
+
+// En passant is easier to play out than to reason about pins and checks, since
+// two pieces leave the king's lines at once
+template<Color Us>
+bool BitBoard::isLegalEnPassant(uint8_t const from, MoveGenMasks const& masks) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    uint8_t epSquare = s[Us].enPassantSquare;
+    uint64_t captured = 1ull << (Us == WHITE ? epSquare - 8 : epSquare + 8);
+    uint64_t occupied = ((s[Us].occupancy | s[Them].occupancy) ^ (1ull << from) ^ captured) | (1ull << epSquare);
+    return !(attackersTo(masks.kingSquare, occupied) & s[Them].occupancy & ~captured);
+}
+
+template<Color Us>
+uint32_t BitBoard::getPawnMoves(Move*& moves, MoveGenMasks const& masks, GenType type) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    constexpr int8_t up = (Us == WHITE) ? 8 : -8;
+    constexpr uint8_t startRank = (Us == WHITE) ? 1 : 6;
+    constexpr uint8_t promoteRank = (Us == WHITE) ? 7 : 0;
+
+    uint8_t pos, newpos;
+    uint64_t bb = p[Us].pawn;
+    uint32_t numMoves = 0;
+    uint64_t empty = ~(s[Us].occupancy | s[Them].occupancy);
+
+    while (bb) {
+        // Isolate the least significant bit and find it
+        uint64_t sftBoard = bb & -bb;
+        pos = __builtin_ctzll(bb);
+        uint64_t allowed = masks.targets;
+        if (masks.pinned & sftBoard) allowed &= Attacks::line(masks.kingSquare, pos);
+
+        if (type != CAPTURES) {
+            // Up/down one
+            uint64_t s1 = (Us == WHITE ? shiftNorth(sftBoard) : shiftSouth(sftBoard)) & empty;
+            if (s1 & allowed) {
+                newpos = pos + up;
+                // Promotion
+                if (newpos / 8 == promoteRank) {
+                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, QUEEN);
+                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, KNIGHT);
+                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, ROOK);
+                    *(moves++) = Move(pos, newpos, PROMOTION_MOVE, BISHOP);
+                    numMoves += 4;
+                } else {
+                    *(moves++) = Move(pos, newpos);
+                    numMoves++;
+                }
+            }
+            // Move up 2, the first square only has to be empty since we may be blocking a check on the second
+            if (s1 && pos / 8 == startRank) {
+                uint64_t s2 = (Us == WHITE ? shiftNorth(s1) : shiftSouth(s1)) & empty & allowed;
+                if (s2) {
+                    *(moves++) = Move(pos, pos + 2*up);
+                    numMoves++;
+                }
+            }
+        }
+
+        // Kill adjacent piece
+        uint64_t attacks = Attacks::pawnAttacks(Us, pos) & s[Them].occupancy & allowed;
+        while (attacks) {
+            uint64_t m = attacks & -attacks;
+            newpos = __builtin_ctzll(m);
+            if (newpos / 8 == promoteRank) {
+                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, QUEEN);
+                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, KNIGHT);
+                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, ROOK);
+                *(moves++) = Move(pos, newpos, PROMOTE_CAPTURE, BISHOP);
+                numMoves += 4;
+            } else {
+                *(moves++) = Move(pos, newpos, CAPTURE_MOVE);
+                numMoves++;
+            }
+            attacks &= attacks - 1;
+        }
+
+        // Move onto the next pawn
+        bb &= bb - 1;
+    }
+
+    uint8_t epSquare = s[Us].enPassantSquare;
+    if (epSquare && type != QUIETS) {
+        uint64_t attackers = Attacks::pawnAttacks(Them, epSquare) & p[Us].pawn;
+        while (attackers) {
+            pos = __builtin_ctzll(attackers);
+            if (isLegalEnPassant<Us>(pos, masks)) {
+                *(moves++) = Move(pos, epSquare, EN_PASSANT_MOVE);
+                numMoves++;
+            }
+            attackers &= attackers - 1;
+        }
+    }
+    return numMoves;
+}
+
+template<Color Us>
+uint32_t BitBoard::getKingMoves(Move*& moves, MoveGenMasks const& masks, GenType type) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    // King start square and the squares it passes through when castling
+    constexpr uint8_t kingStart = (Us == WHITE) ? 4 : 60;
+    constexpr uint64_t shortPath = 0x60ull << (kingStart - 4);
+    constexpr uint64_t longPath = 0x0eull << (kingStart - 4);
+
+    uint8_t pos = masks.kingSquare;
+    uint8_t newpos;
+    uint32_t numMoves = 0;
+    uint64_t occupied = s[Us].occupancy | s[Them].occupancy;
+
+    if (type != CAPTURES && !masks.checkers) {
+        // Castling, squares the king passes through must be empty and not attacked
+        if (s[Us].castleShort) {
+            if (!(shortPath & occupied) && !isAttacked(kingStart+1, Us, occupied) && !isAttacked(kingStart+2, Us, occupied)) {
+                *(moves++) = Move(kingStart, kingStart+2, CASTLE_MOVE);
+                numMoves++;
+            }
+        }
+        if (s[Us].castleLong) {
+            if (!(longPath & occupied) && !isAttacked(kingStart-1, Us, occupied) && !isAttacked(kingStart-2, Us, occupied)) {
+                *(moves++) = Move(kingStart, kingStart-2, CASTLE_MOVE);
+                numMoves++;
+            }
+        }
+    }
+
+    uint64_t attacks = Attacks::kingAttacks(pos) & ~s[Us].occupancy;
+    if (type == CAPTURES) attacks &= s[Them].occupancy;
+    if (type == QUIETS) attacks &= ~s[Them].occupancy;
+    // Take the king off the board so sliders checking it also cover the squares behind it
+    occupied ^= p[Us].king;
+    while (attacks) {
+        uint64_t m = attacks & -attacks;
+        newpos = __builtin_ctzll(m);
+        if (!isAttacked(newpos, Us, occupied)) {
+            *(moves++) = Move(pos, newpos, (m & s[Them].occupancy) ? CAPTURE_MOVE : DEFAULT_MOVE);
+            numMoves++;
+        }
+        attacks &= attacks - 1;
+    }
+
+    return numMoves;
+}
+
+template<Color Us>
+uint32_t BitBoard::getKnightMoves(Move*& moves, MoveGenMasks const& masks) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    uint8_t pos, newpos;
+    // A pinned knight can never stay on the pin line
+    uint64_t bb = p[Us].knight & ~masks.pinned;
+    uint32_t numMoves = 0;
+
+    while (bb) {
+        // Isolate the least significant bit and find it
+        pos = __builtin_ctzll(bb);
+        uint64_t attacks = Attacks::knightAttacks(pos) & masks.targets;
+        while (attacks) {
+            uint64_t m = attacks & -attacks;
+            newpos = __builtin_ctzll(m);
+            *(moves++) = Move(pos, newpos, (m & s[Them].occupancy) ? CAPTURE_MOVE : DEFAULT_MOVE);
+            numMoves++;
+            attacks &= attacks - 1;
+        }
+        // Clear last least significant bit
+        bb &= bb - 1;
+    }
+    return numMoves;
+}
+
+template<Color Us>
+uint32_t BitBoard::getRookMoves(Move*& moves, MoveGenMasks const& masks) const {
+    uint64_t bb = p[Us].rook | p[Us].queen;
+    return getSlidingMoves<Us>(bb, &Attacks::rookAttacks, moves, masks);
+}
+
+template<Color Us>
+uint32_t BitBoard::getBishopMoves(Move*& moves, MoveGenMasks const& masks) const {
+    uint64_t bb = p[Us].bishop | p[Us].queen;
+    return getSlidingMoves<Us>(bb, &Attacks::bishopAttacks, moves, masks);
+}
+
+template<Color Us>
+BitBoard::MoveGenMasks BitBoard::getMoveGenMasks(GenType type) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    MoveGenMasks masks;
+    masks.kingSquare = __builtin_ctzll(p[Us].king);
+    masks.checkers = attackersTo(masks.kingSquare, s[Us].occupancy | s[Them].occupancy) & s[Them].occupancy;
+    assert(type != EVASIONS || masks.checkers);
+    masks.pinned = pinnedPieces(Us);
+    masks.targets = (type == CAPTURES) ? s[Them].occupancy
+                  : (type == QUIETS) ? ~(s[Us].occupancy | s[Them].occupancy)
+                  : ~s[Us].occupancy;
+
+    if (masks.checkers & (masks.checkers - 1)) {
+        // Only the king can move out of a double check
+        masks.targets = 0;
+    } else if (masks.checkers) {
+        // Capture the checker or block it
+        masks.targets &= masks.checkers | Attacks::between(masks.kingSquare, __builtin_ctzll(masks.checkers));
+    }
+    return masks;
+}
+
+// Quiet moves that give direct check, from the squares each piece type would attack
+// the enemy king from, or discovered check. Castling and promotions are left out.
+template<Color Us>
+uint8_t BitBoard::generateQuietChecks(Move* moves) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    uint8_t ksq = __builtin_ctzll(p[Them].king);
+    uint64_t occupied = s[Us].occupancy | s[Them].occupancy;
+    uint64_t const checkSquares[7] = {
+        0,
+        Attacks::pawnAttacks(Them, ksq),
+        Attacks::rookAttacks(ksq, occupied),
+        Attacks::knightAttacks(ksq),
+        Attacks::bishopAttacks(ksq, occupied),
+        Attacks::queenAttacks(ksq, occupied),
+        0
+    };
+    uint64_t discovered = discoveredCheckers(Us);
+
+    uint8_t numQuiets = generateMoves<Us>(moves, QUIETS);
+    uint8_t numMoves = 0;
+    for (uint8_t i = 0; i < numQuiets; i++) {
+        Move const m = moves[i];
+        if (m.isCastle() || m.isPromotion()) continue;
+        uint64_t toBB = 1ull << m.to();
+        bool direct = checkSquares[pieceOn[m.from()]] & toBB;
+        bool uncovers = (discovered & (1ull << m.from())) && !(Attacks::line(ksq, m.from()) & toBB);
+        if (direct || uncovers) moves[numMoves++] = m;
+    }
+    return numMoves;
+}
+
+template<Color Us>
+uint8_t BitBoard::generateMoves(Move* moves, GenType type) const {
+    if (type == QUIET_CHECKS) return generateQuietChecks<Us>(moves);
+
+    uint32_t numMoves = 0;
+
+    MoveGenMasks masks = getMoveGenMasks<Us>(type);
+
+    numMoves += getKingMoves<Us>(moves, masks, type);
+
+    if (masks.targets) {
+        numMoves += getPawnMoves<Us>(moves, masks, type);
+        numMoves += getKnightMoves<Us>(moves, masks);
+        numMoves += getRookMoves<Us>(moves, masks);
+        numMoves += getBishopMoves<Us>(moves, masks);
+    }
+
+    assert(numMoves < MAX_MOVES);
+    return numMoves;
+}
+
+uint8_t BitBoard::getAvailableMoves(std::array<Move,MAX_MOVES>& movesAvailable, GenType type) const {
+    return getAvailableMoves(movesAvailable.data(), type);
+}
+
+// The side to move is fixed for the whole node, so pick the generator once
+uint8_t BitBoard::getAvailableMoves(Move* movesAvailable, GenType type) const {
+    return (turn == WHITE) ? generateMoves<WHITE>(movesAvailable, type)
+                           : generateMoves<BLACK>(movesAvailable, type);
+}
+
+// Validates a move that didn't come from the generator for this position, like a TT or
+// killer move. Its flags have to match what the generator would have produced.
+template<Color Us>
+bool BitBoard::isLegalMove(Move const& move) const {
+    constexpr Color Them = static_cast<Color>(!Us);
+    constexpr uint8_t startRank = (Us == WHITE) ? 1 : 6;
+
+    uint8_t from = move.from();
+    uint8_t to = move.to();
+    uint64_t fromBB = 1ull << from;
+    uint64_t toBB = 1ull << to;
+    uint64_t occupied = s[Us].occupancy | s[Them].occupancy;
+
+    if (!move.valid() || !(s[Us].occupancy & fromBB) || (s[Us].occupancy & toBB)) return false;
+    uint16_t flags = move.data & 0xf000;
+    if (!move.isPromotion() && flags != DEFAULT_MOVE && flags != CAPTURE_MOVE
+        && flags != EN_PASSANT_MOVE && flags != CASTLE_MOVE) return false;
+
+    enum Piece piece = pieceOn[from];
+    bool isCapture = s[Them].occupancy & toBB;
+    MoveGenMasks masks = getMoveGenMasks<Us>(ALL_MOVES);
+
+    if (piece == KING) {
+        if (move.promote() != EMPTY || move.isEnPassant()) return false;
+        if (move.isCastle()) {
+            if (masks.checkers) return false;
+            if (to == from + 2 && s[Us].castleShort) {
+                uint64_t path = (1ull << (from+1)) | (1ull << (from+2));
+                return !(path & occupied) && !isAttacked(from+1, Us, occupied) && !isAttacked(from+2, Us, occupied);
+            }
+            if (to == from - 2 && s[Us].castleLong) {
+                uint64_t path = (1ull << (from-1)) | (1ull << (from-2)) | (1ull << (from-3));
+                return !(path & occupied) && !isAttacked(from-1, Us, occupied) && !isAttacked(from-2, Us, occupied);
+            }
+            return false;
+        }
+        if (!(Attacks::kingAttacks(from) & toBB) || move.isCapture() != isCapture) return false;
+        return !isAttacked(to, Us, occupied ^ fromBB);
+    }
+
+    if (move.isCastle()) return false;
+    // Only the king can move out of a double check
+    if (masks.checkers & (masks.checkers - 1)) return false;
+
+    if (piece == PAWN) {
+        bool isEnPassant = s[Us].enPassantSquare && to == s[Us].enPassantSquare
+                        && (Attacks::pawnAttacks(Us, from) & toBB);
+        if (move.isEnPassant() != isEnPassant) return false;
+        if (isEnPassant) return move.isCapture() && isLegalEnPassant<Us>(from, masks);
+
+        bool lastRank = (to / 8 == 0) || (to / 8 == 7);
+        if (lastRank != move.isPromotion()) return false;
+
+        if (isCapture) {
+            if (!(Attacks::pawnAttacks(Us, from) & toBB)) return false;
+        } else {
+            uint64_t s1 = (Us == WHITE ? shiftNorth(fromBB) : shiftSouth(fromBB)) & ~occupied;
+            uint64_t s2 = (from / 8 == startRank) ? (Us == WHITE ? shiftNorth(s1) : shiftSouth(s1)) & ~occupied : 0;
+            if (!((s1 | s2) & toBB)) return false;
+        }
+    } else {
+        if (move.promote() != EMPTY || move.isEnPassant()) return false;
+        uint64_t attacks = (piece == KNIGHT) ? Attacks::knightAttacks(from)
+                         : (piece == BISHOP) ? Attacks::bishopAttacks(from, occupied)
+                         : (piece == ROOK) ? Attacks::rookAttacks(from, occupied)
+                         : Attacks::queenAttacks(from, occupied);
+        if (!(attacks & toBB)) return false;
+    }
+
+    if (move.isCapture() != isCapture) return false;
+    if (!(masks.targets & toBB)) return false;
+    return !(masks.pinned & fromBB) || (Attacks::line(masks.kingSquare, from) & toBB);
+}
+
+bool BitBoard::isLegalMove(Move const& move) const {
+    return (turn == WHITE) ? isLegalMove<WHITE>(move) : isLegalMove<BLACK>(move);
+}
+
+bool BitBoard::testInCheck(bool c) const {
+    return isAttacked(__builtin_ctzll(p[c].king), c, s[c].occupancy | s[!c].occupancy);
+}
+
+int32_t BitBoard::evaluateKingSafety() const {
+    int32_t numPos = 0;
+    // King safety. Pretend king was a queen and see how far it can go. Penalize more available moves.
+    numPos = 0;
+    uint64_t occupied = ~(s[turn].occupancy | s[!turn].occupancy);
+
+    #ifdef USE_AVX2
+    uint64_t attacks[8];
+    Attacks::slidingAttacks(p[turn].king, p[turn].king, occupied, attacks);
+    for (uint64_t a : attacks) {
+        numPos += __builtin_popcountll(a & occupied);
+    }
+    #else
+    auto slidingFuncs = {&shiftNorth, &shiftEast, &shiftSouth, &shiftWest, &shiftNoEast, &shiftNoWest, &shiftSoEast, &shiftSoWest};
+    for (auto func : slidingFuncs) {
+        uint64_t sft = p[turn].king;
+        while (sft) {
+            sft = func(sft);
+            sft &= occupied;
+            if (sft) numPos++;
+        }
+    }
+    #endif
+
+    return numPos;
+}
+
+int32_t BitBoard::estimateMoveValue(Move const& move) const {
+    static constexpr int32_t CAPTURE_BONUS = 75;
+    static constexpr int32_t CASTLE_BONUS = 100;
+
+    int32_t value = 0;
+
+    value += move.isCapture() * CAPTURE_BONUS;
+    value += move.isCastle() * CASTLE_BONUS;
+
+    // Benefit to put our piece on a good square
+    value += pstDelta(move, calculateEndgameBlendFactor());
+    
+    // Material won or lost on the target square, including promotions
+    value += see(move);
+
+    return value;
+}
+
+int32_t BitBoard::pstDelta(Move const& move, float egBlend) const {
+    Piece source = pieceOn[move.from()];
+    Score const& from = PSQ.s[turn][source][move.from()];
+    Score const& to = PSQ.s[turn][source][move.to()];
+    float mgBlend = 1-egBlend;
+    int32_t pst = mgBlend*(to.pstMg - from.pstMg) + egBlend*(to.pstEg - from.pstEg);
+
+    return Evaluate::PST_FACTOR * pst;
+}
+
+float BitBoard::calculateEndgameBlendFactor() const {
+    uint32_t material = 0;
+    static constexpr uint32_t maxMaterial = QUEEN_VALUE_MG + (2*KNIGHT_VALUE_MG) + (2*BISHOP_VALUE_MG) + (2*ROOK_VALUE_MG);
+    static constexpr uint32_t egCutoff = QUEEN_VALUE_MG - PAWN_VALUE_MG;
+
+    // Only count opponents non-pawn material
+    material += __builtin_popcountll(p[!turn].queen) * QUEEN_VALUE_MG;
+    material += __builtin_popcountll(p[!turn].knight) * KNIGHT_VALUE_MG;
+    material += __builtin_popcountll(p[!turn].bishop) * BISHOP_VALUE_MG;
+    material += __builtin_popcountll(p[!turn].rook) * ROOK_VALUE_MG;
+
+    if (material <= egCutoff) return 1;
+
+    return 1 - (static_cast<float>(material - egCutoff) / static_cast<float>(maxMaterial - egCutoff));
+}
+
+void BitBoard::sortMoves(std::array<Move,MAX_MOVES>& moves,
+                                uint8_t numMoves, Move const& ttMove) const 
+{
+    std::array<int32_t,MAX_MOVES> scores;
+    for (uint8_t i = 0; i < numMoves; i++) {
+        scores[i] = estimateMoveValue(moves[i]);
+        if (moves[i] == ttMove) scores[i] += 10000;
+        #ifdef HISTORY_HEURISTIC
+        scores[i] += tt->getHistoryScore(turn, moves[i]);
+        #endif
+    }
+
+    // Insertion sort, moving each score along with its move
+    for (uint8_t i = 1; i < numMoves; i++) {
+        Move move = moves[i];
+        int32_t score = scores[i];
+        uint8_t j = i;
+        for (; j > 0 && scores[j-1] < score; j--) {
+            moves[j] = moves[j-1];
+            scores[j] = scores[j-1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
 }
\ No newline at end of file
@@ -1,143 +1,244 @@
-#ifndef __BIT_BOARD_INC_GUARD__
-#define __BIT_BOARD_INC_GUARD__
-
-#include <iostream>
-#include <assert.h>
-#include <vector>
-#include <array>
-#include <algorithm>
-#include <cstring>
-
-#include "defines.hpp"
-
-class TT;
-
-class BitBoard {
-    public:
-        struct MoveData {
-            bool isCapture;
-            bool isCastle;
-            bool isEnPassant;
-            bool isPromotion;
-        };
-
-        struct Move {
-            int32_t value;
-            uint8_t from;
-            uint8_t to;
-            BitBoardState::Piece promote;
-            MoveData moveData;
-
-            Move(uint8_t _from=0, uint8_t _to=0, const MoveData& _moveData=DEFAULT_MOVE, 
-                 BitBoardState::Piece _promote=BitBoardState::EMPTY) 
-                : from(_from), to(_to), promote(_promote), moveData(_moveData) {};
-            bool valid() const {
-                return from != to;
-            }
-            bool operator==(const Move& other) const {
-                return from == other.from && to == other.to && promote == other.promote;
-            }
-        };
-
-        struct Pieces {
-            uint64_t pawn;
-            uint64_t knight;
-            uint64_t bishop;
-            uint64_t rook;
-            uint64_t queen;
-            uint64_t king;
-        } p[2]; // White, black
-
-        struct CachedState {
-            uint64_t occupancy;
-            uint64_t mobility;
-            uint32_t scope;
-            uint8_t enPassantSquare;
-            bool castleShort;
-            bool castleLong;
-        } s[2];
-
-        class History {
-            public:
-                History() : h(), idx(0) { }
-                bool isRepeat(uint64_t hash) {
-                    for (uint8_t i = 0; i < 4; i++) {
-                        if (hash == h[i]) {
-                            return true;
-                        }
-                    }
-                    return false;
-                }
-
-                void insert(uint64_t hash) {
-                    h[idx] = hash;
-                    idx++;
-                    idx &= 0x3;
-                }
-            private:
-                uint64_t h[4];
-                uint8_t idx;
-        } history;
-
-        static const MoveData DEFAULT_MOVE;
-        static const MoveData CAPTURE_MOVE;
-        static const MoveData EN_PASSANT_MOVE;
-        static const MoveData CASTLE_MOVE;
-        static const MoveData PROMOTION_MOVE;
-        static const MoveData PROMOTE_CAPTURE;
-
-        uint64_t knightAttacks[64];
-        uint64_t pawnAttacks[2][64];
-        uint64_t kingAttacks[64];
-
-        uint64_t hash;
-        int32_t value;
-        uint32_t moves;
-        BitBoardState::Color turn;
-
-        TT* tt;
-
-        bool operator==(const BitBoard &other) const { 
-            assert(0); // Should never need to deep compare boards, only hashes
-            return hash == other.hash;
-        }
-
-        BitBoard(TT* _tt=nullptr, bool startpos=true);
-        int32_t getBoardValue() const;
-        void changeTurn();
-        int32_t getPieceValue(BitBoardState::Piece const& piece) const;
-        void printBoard() const;
-        void printMobility() const;
-        static void strToMove(std::string const& moveText, struct Move& move);
-        static std::string moveToStr(struct Move const& move);
-        void movePiece(struct Move const& move);
-        void sortMoves(std::array<Move,MAX_MOVES>& moves, uint8_t numMoves, struct Move const& ttMove) const;
-        uint8_t getAvailableMoves(std::array<Move,MAX_MOVES>& movesAvailable, bool capturesOnly=false) const;
-        bool testInCheck(bool c) const;
-        int32_t estimateMoveValue(struct Move const& move) const;
-        void recalculateOccupancy();
-        void recalculateThreats();
-        int32_t evaluateKingSafety() const;
-        float calculateEndgameBlendFactor() const;
-        enum BitBoardState::Piece getPiece(struct Pieces const& p, uint8_t pos) const;
-
-    private:
-        void maskClearBitBoard(enum BitBoardState::Piece piece, bool c, uint64_t m);
-        void maskSetBitBoard(enum BitBoardState::Piece piece, bool c, uint64_t m);
-        std::string pieceToUnicode(enum BitBoardState::Piece piece, enum BitBoardState::Color c) const;
-        void validateBitBoard() const;
-        bool isAvailable(uint8_t const pos) const;
-        bool isOccupied(uint8_t const pos) const;
-
-        uint32_t searchStraight(uint64_t bitboard, uint64_t shiftFunc(uint64_t const b), 
-                                       std::array<Move,MAX_MOVES>::iterator& moves, 
-                                       bool capturesOnly=false) const;
-        int32_t pstDelta(struct Move const& move) const;
-        uint32_t getPawnMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const;
-        uint32_t getKingMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const;
-        uint32_t getKnightMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const;
-        uint32_t getRookMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const;
-        uint32_t getBishopMoves(std::array<Move,MAX_MOVES>::iterator& moves, bool capturesOnly) const;
-        void maskIfPositionAttacked(uint64_t& bb, bool c) const;
-};
+#ifndef __BIT_BOARD_INC_GUARD__
+#define __BIT_BOARD_INC_GUARD__
+
+#include <iostream>
+#include <assert.h>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "defines.hpp"
+
+class TT;
+
+// Position state only. Attack tables live in Attacks so that copy-make only copies the position.
+class BitBoard {
+    public:
+        // Move flags, packed into the top four bits of Move::data. Promotions keep
+        // the promoted piece in the two low flag bits.
+        enum MoveData : uint16_t {
+            DEFAULT_MOVE    = 0,
+            EN_PASSANT_MOVE = 0x5000,
+            CASTLE_MOVE     = 0x2000,
+            CAPTURE_MOVE    = 0x4000,
+            PROMOTION_MOVE  = 0x8000,
+            PROMOTE_CAPTURE = 0xc000,
+        };
+
+        // from in bits 0-5, to in bits 6-11, flags in 12-15. Scores used for
+        // ordering are kept alongside the move list, not in the move.
+        struct Move {
+            uint16_t data;
+
+            Move(uint8_t _from=0, uint8_t _to=0, MoveData _moveData=DEFAULT_MOVE, 
+                 BitBoardState::Piece _promote=BitBoardState::EMPTY) 
+                : data(_from | (_to << 6) | _moveData
+                       | (_promote ? (_promote - BitBoardState::ROOK) << 12 : 0)) {};
+            uint8_t from() const { return data & 0x3f; }
+            uint8_t to() const { return (data >> 6) & 0x3f; }
+            bool isCapture() const { return data & CAPTURE_MOVE; }
+            bool isPromotion() const { return data & PROMOTION_MOVE; }
+            bool isEnPassant() const { return (data & 0xf000) == EN_PASSANT_MOVE; }
+            bool isCastle() const { return (data & 0xf000) == CASTLE_MOVE; }
+            BitBoardState::Piece promote() const {
+                return isPromotion() ? static_cast<BitBoardState::Piece>(((data >> 12) & 0x3) + BitBoardState::ROOK)
+                                     : BitBoardState::EMPTY;
+            }
+            bool valid() const {
+                return from() != to();
+            }
+            // Same squares and promotion, flags only describe the position the move came from
+            bool operator==(const Move& other) const {
+                return (data & 0x0fff) == (other.data & 0x0fff) && promote() == other.promote();
+            }
+        };
+
+        struct Pieces {
+            uint64_t pawn;
+            uint64_t knight;
+            uint64_t bishop;
+            uint64_t rook;
+            uint64_t queen;
+            uint64_t king;
+        } p[2]; // White, black
+
+        struct CachedState {
+            uint64_t occupancy;
+            uint8_t enPassantSquare;
+            bool castleShort;
+            bool castleLong;
+        } s[2];
+
+        // Attacked squares and attacked piece count per side. Only evaluation and move
+        // ordering read these, so they are rebuilt lazily through getThreats()
+        struct Threats {
+            uint64_t mobility;
+            uint16_t scope;
+        };
+
+        class History {
+            public:
+                History() : h(), idx(0) { }
+                bool isRepeat(uint64_t hash) {
+                    for (uint8_t i = 0; i < 4; i++) {
+                        if (hash == h[i]) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Returns the entry that was overwritten so it can be put back with undo()
+                uint64_t insert(uint64_t hash) {
+                    uint64_t evicted = h[idx];
+                    h[idx] = hash;
+                    idx++;
+                    idx &= 0x3;
+                    return evicted;
+                }
+
+                void undo(uint64_t evicted) {
+                    idx--;
+                    idx &= 0x3;
+                    h[idx] = evicted;
+                }
+            private:
+                uint64_t h[4];
+                uint8_t idx;
+        };
+
+        // Everything unmakeMove can't recompute cheaply from the move itself
+        struct UndoInfo {
+            CachedState s[2];
+            Threats t[2];
+            uint64_t hash;
+            uint64_t pawnKey;
+            uint64_t materialKey;
+            uint64_t nonPawnKey[2];
+            BitBoardState::Piece captured;
+            bool threatsValid;
+        };
+
+        // Which part of the move list getAvailableMoves produces. EVASIONS is only for
+        // positions in check: king moves to safe squares and, against a single checker,
+        // captures of the checker and interpositions. QUIET_CHECKS is the subset of
+        // QUIETS that puts the opponent in check.
+        enum GenType { ALL_MOVES, CAPTURES, QUIETS, EVASIONS, QUIET_CHECKS };
+
+        // Material and piece-square sums per side, kept in sync with p by
+        // maskSetBitBoard/maskClearBitBoard so evaluation doesn't walk the pieces
+        struct Score {
+            int16_t materialMg;
+            int16_t materialEg;
+            int16_t pstMg;
+            int16_t pstEg;
+        } score[2];
+
+        uint64_t hash;
+        // Secondary Zobrist keys for pawn/material caches, updated in movePiece like hash
+        uint64_t pawnKey;       // Pawns and kings of both sides
+        uint64_t materialKey;   // Piece counts of both sides
+        uint64_t nonPawnKey[2]; // Everything but pawns, per side
+        uint16_t moves;
+        BitBoardState::Color turn;
+
+        TT* tt;
+        History history;
+
+        // Square to piece lookup, kept in sync with p by maskSetBitBoard/maskClearBitBoard
+        BitBoardState::Piece pieceOn[64];
+
+        Threats const& getThreats(bool c) const {
+            if (!threatsValid) recalculateThreats();
+            return t[c];
+        }
+
+        bool operator==(const BitBoard &other) const { 
+            assert(0); // Should never need to deep compare boards, only hashes
+            return hash == other.hash;
+        }
+
+        BitBoard(TT* _tt=nullptr, bool startpos=true);
+        int32_t getBoardValue() const;
+        void changeTurn();
+        int32_t getPieceValue(BitBoardState::Piece const& piece) const;
+        void printBoard() const;
+        void printMobility() const;
+        static void strToMove(std::string const& moveText, struct Move& move);
+        static std::string moveToStr(struct Move const& move);
+        void movePiece(struct Move const& move);
+        void makeMove(struct Move const& move, UndoInfo& undo);
+        void unmakeMove(struct Move const& move, UndoInfo const& undo);
+        void makeNullMove(UndoInfo& undo);
+        void unmakeNullMove(UndoInfo const& undo);
+        void sortMoves(std::array<Move,MAX_MOVES>& moves, uint8_t numMoves, struct Move const& ttMove) const;
+        uint8_t getAvailableMoves(std::array<Move,MAX_MOVES>& movesAvailable, GenType type=ALL_MOVES) const;
+        uint8_t getAvailableMoves(Move* movesAvailable, GenType type=ALL_MOVES) const;
+        bool isLegalMove(struct Move const& move) const;
+        bool testInCheck(bool c) const;
+        uint64_t attackersTo(uint8_t const sq, uint64_t const occupied) const;
+        uint64_t pinnedPieces(bool c) const;
+        uint64_t discoveredCheckers(bool c) const;
+        int32_t estimateMoveValue(struct Move const& move) const;
+        int32_t see(struct Move const& move) const;
+        int32_t pstDelta(struct Move const& move, float egBlend) const;
+        void recalculateOccupancy();
+        void recalculateMailbox();
+        void recalculateScore();
+        void recalculateKeys();
+        void recalculateThreats() const;
+        int32_t evaluateKingSafety() const;
+        float calculateEndgameBlendFactor() const;
+        enum BitBoardState::Piece getPiece(struct Pieces const& p, uint8_t pos) const;
+
+    private:
+        mutable Threats t[2];
+        mutable bool threatsValid;
+
+        template<BitBoardState::Color Us> void movePiece(struct Move const& move);
+        template<BitBoardState::Color Us> void unmakeMove(struct Move const& move, UndoInfo const& undo);
+        void maskClearBitBoard(enum BitBoardState::Piece piece, bool c, uint64_t m);
+        void maskSetBitBoard(enum BitBoardState::Piece piece, bool c, uint64_t m);
+        void updateKeys(enum BitBoardState::Piece piece, bool c, uint8_t pos, bool added);
+        void updateScore(enum BitBoardState::Piece piece, bool c, uint8_t pos, int8_t sign);
+        std::string pieceToUnicode(enum BitBoardState::Piece piece, enum BitBoardState::Color c) const;
+        void validateBitBoard() const;
+        bool isAvailable(uint8_t const pos) const;
+        bool isOccupied(uint8_t const pos) const;
+
+        // Per node constraints shared by the piece move generators
+        struct MoveGenMasks {
+            uint64_t targets;   // Squares a non-king piece may move to
+            uint64_t pinned;    // Our pieces pinned against our king
+            uint64_t checkers;  // Enemy pieces giving check
+            uint8_t kingSquare;
+        };
+
+        // Generators are instantiated per side to move so directions, promotion ranks
+        // and castling squares are compile time constants
+        template<BitBoardState::Color Us>
+        uint32_t getSlidingMoves(uint64_t bitboard, uint64_t attackFunc(uint8_t const sq, uint64_t const occ), 
+                                 Move*& moves, MoveGenMasks const& masks) const;
+        template<BitBoardState::Color Us> uint8_t generateMoves(Move* moves, GenType type) const;
+        template<BitBoardState::Color Us> uint8_t generateQuietChecks(Move* moves) const;
+        uint64_t sliderBlockers(uint8_t const ksq, uint64_t snipers, bool owner) const;
+        template<BitBoardState::Color Us> MoveGenMasks getMoveGenMasks(GenType type) const;
+        template<BitBoardState::Color Us> bool isLegalEnPassant(uint8_t const from, MoveGenMasks const& masks) const;
+        template<BitBoardState::Color Us> bool isLegalMove(struct Move const& move) const;
+        template<BitBoardState::Color Us> uint32_t getPawnMoves(Move*& moves, MoveGenMasks const& masks, GenType type) const;
+        template<BitBoardState::Color Us> uint32_t getKingMoves(Move*& moves, MoveGenMasks const& masks, GenType type) const;
+        template<BitBoardState::Color Us> uint32_t getKnightMoves(Move*& moves, MoveGenMasks const& masks) const;
+        template<BitBoardState::Color Us> uint32_t getRookMoves(Move*& moves, MoveGenMasks const& masks) const;
+        template<BitBoardState::Color Us> uint32_t getBishopMoves(Move*& moves, MoveGenMasks const& masks) const;
+        bool isAttacked(uint8_t const sq, bool c, uint64_t const occupied) const;
+};
+
+static_assert(sizeof(BitBoard::Move) == 2, "Moves are packed into 16 bits");
+
+// Search saves and restores boards by plain copy, keep it cheap
+static_assert(std::is_trivially_copyable<BitBoard>::value, "BitBoard must be trivially copyable");
+// Pinned to the current size so that any growth is a deliberate choice
+static_assert(sizeof(BitBoard) == 344, "BitBoard changed size, 344 bytes spans six cache lines");
 #endif
\ No newline at end of file
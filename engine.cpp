@@ -1,501 +1,881 @@
-#include <cstring>
-
-#include "engine.hpp"
-#include "evaluate.hpp"
-#include "sohilbot.hpp"
-#include "transpositionTables.hpp"
-
-int32_t Engine::searchBestMove(BitBoard& board, BitBoard::Move& move, 
-                               uint8_t depth, uint32_t time)
-{
-    uint8_t const iterStart = 1;
-    int32_t eval = 0;
-    npos = 0;
-    branches = 0;
-    prevTime = 0;
-    numRedos=0;
-    numReductions=0;
-    numTTLookups=0;
-    numTTHits=0;
-    numTTSoftmiss=0;
-    numTTEvictions=0;
-    numTTFills=0;
-    numNullReductions=0;
-    aspirationRetries=0;
-    timelimit = time;
-    seldepth = 0;
-    shouldStop = false;
-
-    depth = std::min(static_cast<int>(depth), MAX_DEPTH-1);
-
-    int32_t alpha = NEG_INF;
-    int32_t beta = INF;
-
-    BitBoard oldBoard = board;
-
-    memset(&currPvs, 0, sizeof(Line)*MAX_DEPTH*MAX_PVS);
-    memset(&pvs, 0, sizeof(Line)*MAX_PVS);
-
-    board.tt->clearHistory();
-
-    // Initialize evals to -INF
-    for (uint8_t pv = 0; pv < numPvs; pv++) {
-        pvs[pv].eval = NEG_INF;
-        for (uint8_t depth = 0; depth < MAX_DEPTH; depth++) {
-            currPvs[pv][depth].eval = NEG_INF;
-        }
-    }
-
-    timeStart = std::chrono::high_resolution_clock::now();
-    for (depthIter = iterStart; depthIter <= depth; depthIter++) {
-        aspirationRetries = 1;
-        numReductions = 0;
-        numNullReductions = 0;
-        numRedos = 0;
-        branches = 0;
-
-        quiesceDepth = std::min(depthIter * 2, MAX_DEPTH-1);
-
-        board.tt->clearHistory();
-        do {
-            #ifdef ENABLE_ASPIRATION
-            if (aspirationRetries > 2) {
-                // If we tried 2 times, search full window
-                alpha = NEG_INF;
-                beta = INF;
-            } else {
-                if (eval >= beta) beta += ASPIRATION_DELTA * aspirationRetries;
-                if (eval <= alpha) alpha -= ASPIRATION_DELTA * aspirationRetries;
-            }
-            #endif
-            eval = recursiveDepthSearch(board, alpha, beta, depthIter, 0);
-            aspirationRetries++;
-        } while (!shouldStop && (eval > beta || eval < alpha));
-
-        #ifdef ENABLE_ASPIRATION
-        beta = eval + ASPIRATION_START;
-        alpha = eval - ASPIRATION_START;
-        #endif
-
-        for (uint8_t pv = 0; pv < numPvs; pv++) {
-            // Could've stopped before we found all PVs, then don't copy over yet
-            if (currPvs[pv][0].moves[0].valid()) {
-                memcpy(&pvs[pv], &currPvs[pv][0], sizeof(Line));
-            }
-        }
-
-        // Ran out of time or got a stop command
-        if (shouldStop) {
-            shouldStop = false;
-            break;
-        }
-
-        sendEngineInfo(depthIter);
-
-        if (abs(eval) > MATE(MAX_DEPTH)) break;
-    }
-
-    board = oldBoard;
-
-#ifdef SEARCH_STATS_ON
-    board.tt->printEstimatedOccupancy();
-    printSearchStats();
-#endif
-/*
-    std::cout << "History scores  |  Move scores" << std::endl;
-    std::array<BitBoard::Move,MAX_MOVES> moves;
-    uint8_t numMoves = board.getAvailableMoves(moves);
-    board.sortMoves(moves, numMoves, BitBoard::Move());
-    for (uint8_t i = 0; i < numMoves; i++) {
-        std::cout << BitBoard::moveToStr(moves[i]) << ": " << std::to_string(board.tt->getHistoryScore(board.turn, moves[i])) 
-                  << "  |  " << std::to_string(moves[i].value) << std::endl;
-    }*/
-
-    move = pvs[0].moves[0];
-    return pvs[0].eval;
-}
-
-int32_t Engine::quiesce(BitBoard& board, int32_t alpha, int32_t const beta, uint8_t const currdepth) {
-    using namespace BitBoardState;
-
-    npos++;
-    if (currdepth > seldepth) {
-        seldepth = currdepth;
-    }
-
-    // Null move test to see if current position already beats beta
-    int32_t staticEval = Evaluate::evaluatePosition(board);
-    #ifndef ENABLE_QUIESCE
-    return staticEval;
-    #endif
-    if (currdepth == quiesceDepth) return staticEval;
-    if (staticEval >= beta) return staticEval;
-    if (staticEval > alpha) alpha = staticEval;
-
-    branches++;
-    std::array<BitBoard::Move,MAX_MOVES> moves = {0};
-    int32_t bestEval = staticEval;
-
-    uint8_t numCaptures = board.getAvailableMoves(moves, true /* capturesOnly */);
-    board.sortMoves(moves, numCaptures, BitBoard::Move());
-
-    for (uint8_t i = 0; i < numCaptures; i++) {
-        BitBoard oldboard = board;
-        board.movePiece(moves[i]);
-
-        // Illegal move check
-        if (board.testInCheck(!board.turn)) {
-            board = oldboard;
-            continue;
-        }
-
-        int32_t eval = -quiesce(board, -beta, -alpha, currdepth+1);
-        board = oldboard;
-
-        if (eval >= beta) return eval;
-        if (eval > alpha) alpha = eval;
-        if (eval > bestEval) bestEval = eval;
-    }
-
-    return bestEval;
-}
-
-inline void Engine::extendSearch(uint8_t& depth, bool inCheck) const {
-    if (depth >= quiesceDepth) return;
-    if (depth < quiesceDepth-1 && inCheck) depth+=2;
-}
-
-inline uint8_t Engine::reduce(uint8_t const currdepth, uint8_t const maxdepth, uint8_t movesSearched) {
-    uint8_t newdepth = maxdepth;
-    #ifdef ENABLE_LMR
-    // Reduce late moves if we can
-    if (currdepth + 1 < maxdepth) {
-        if ((movesSearched > LATE_MOVE_CUTOFF)) {
-            if (currdepth < REDUCE1(maxdepth)) newdepth=REDUCE1(maxdepth);
-            else newdepth = maxdepth-1;
-            numReductions++;
-        } else if ((movesSearched > LATE_MOVE_CUTOFF_2)) {
-            if (currdepth < REDUCE2(maxdepth)) newdepth=REDUCE2(maxdepth);
-            else newdepth = maxdepth-1;
-            numReductions++;
-        }
-    }
-    #endif
-    return newdepth;
-}
-
-inline bool Engine::updatePvs(int32_t& alpha, BitBoard::Move* move,
-                              int32_t newEval, uint8_t const currdepth) {
-    bool raisedAlpha = false;
-
-    // Update pvs
-    uint8_t numPvsToUpdate = (currdepth == 0) ? numPvs : 1;
-    for (uint8_t pv = 0; pv < numPvsToUpdate; pv++) {
-        if (newEval > currPvs[pv][currdepth].eval) {
-            // Shift all pvs after this one down
-            for (uint8_t sft = numPvs-1; sft > pv; sft--) {
-                currPvs[sft][currdepth].eval = currPvs[sft-1][currdepth].eval;
-                memcpy(&currPvs[sft][currdepth].moves[currdepth], &currPvs[sft-1][currdepth].moves[currdepth], 
-                        sizeof(BitBoard::Move)*(MAX_DEPTH-currdepth-1));
-            }
-            currPvs[pv][currdepth].eval = newEval;
-            currPvs[pv][currdepth].moves[currdepth] = *move;
-            // Copy best pv from depth+1 to current depth's nth pv
-            memcpy(&currPvs[pv][currdepth].moves[currdepth+1], &currPvs[0][currdepth+1].moves[currdepth+1], 
-                    sizeof(BitBoard::Move)*(MAX_DEPTH-currdepth-2));
-            break;
-        }
-    }
-
-    if (currdepth == 0 && numPvs > 1) {
-        raisedAlpha = true;
-        // For MultiPV, we want a wider window from the root node so we don't beta-cutoff other PVs
-        alpha = currPvs[numPvs-1][0].eval;
-    } else {
-        if (newEval > alpha) {
-            alpha = newEval;
-            raisedAlpha = true;
-        }
-    }
-
-    return raisedAlpha;
-}
-
-int32_t Engine::recursiveDepthSearch(BitBoard& board,
-                                     int32_t alpha, int32_t beta, 
-                                     uint8_t maxdepth, uint8_t const currdepth)
-{
-    using namespace BitBoardState;
-
-    if (shouldStop) {
-        return NEG_INF;
-    }
-    
-    for (uint8_t pv = 0; pv < numPvs; pv++) {
-        currPvs[pv][currdepth].eval = NEG_INF;
-        memset(&currPvs[pv][currdepth].moves[currdepth], 0, sizeof(BitBoard::Move)*(MAX_DEPTH-currdepth-1));
-    }
-
-    // Check the TT for hits
-    BitBoard::Move ttMove = BitBoard::Move();
-    #ifdef ENABLE_TT
-    TT::TTEntry entry = board.tt->lookupHash(board.hash);
-    numTTLookups++;
-    if (entry.hash == board.hash) {
-        ttMove = entry.move;
-        if (entry.depth >= (maxdepth-currdepth)) {
-            numTTHits++;
-            if (entry.node == TT::PV || (entry.node == TT::ALL && entry.eval < alpha)) {
-                currPvs[0][currdepth].eval = entry.eval;
-                currPvs[0][currdepth].moves[currdepth] = entry.move;
-                return entry.eval;
-            } else if (entry.node == TT::CUT && entry.eval >= beta) {
-                return entry.eval;
-            }
-        } else {
-            numTTSoftmiss++;
-        }
-    } else {
-        if (entry.hash == 0) numTTFills++;
-        else numTTEvictions++;
-    }
-    #endif
-
-    // Base case
-    if (currdepth == maxdepth) {
-        const auto end = std::chrono::high_resolution_clock::now();
-        const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - timeStart);
-        if (time.count() >= (timelimit)) {
-            shouldStop = true;
-        }
-
-        int32_t eval = quiesce(board, alpha, beta, currdepth);
-
-        // Leaf of search tree is PV node
-        board.tt->updateEntry(board, BitBoard::Move(), eval, 0, TT::PV);
-
-        return eval;
-    }
-
-    npos++;
-    branches++;
-    std::array<BitBoard::Move,MAX_MOVES> moves = {0};
-    BitBoard oldboard = board;
-
-    bool inCheck = board.testInCheck(board.turn);
-    // Increase depth of search while still in check
-    if (currdepth == maxdepth - 1) extendSearch(maxdepth, inCheck);
-    uint8_t newdepth = maxdepth;
-
-#ifdef ENABLE_NULL_MOVE
-    if ((currdepth+3 < maxdepth) && !inCheck && board.moves < ENDGAME_CUTOFF) {
-        // Null move reduction: try a Null move and use it to reduce search depth
-        board.changeTurn();
-        board.s[board.turn].enPassantSquare = 0;
-        board.s[!board.turn].enPassantSquare = 0;
-        newdepth = currdepth+3;
-        int32_t eval = -recursiveDepthSearch(board, -beta, -alpha, newdepth, currdepth+1);
-        board = oldboard;
-        if (eval >= beta) {
-            numNullReductions++;
-            if (currdepth < REDUCE1(maxdepth)) {
-                newdepth=REDUCE1(maxdepth);
-            } else {
-                // Doing nothing is already better for us than making a move, just return beta
-                board.tt->updateEntry(board, BitBoard::Move(), beta, maxdepth-currdepth, TT::CUT);
-                return beta;
-            }
-        }
-    }
-#endif
-
-    bool foundLegalMove = false;
-    bool raisedAlpha = false;
-    int32_t bestEval = NEG_INF;
-    BitBoard::Move bestMove = BitBoard::Move();
-
-    uint8_t numMoves = board.getAvailableMoves(moves);
-    assert(numMoves);
-    board.sortMoves(moves, numMoves, ttMove);
-
-    uint8_t movesSearched = 0;
-    for (auto move = moves.begin(); move != moves.begin() + numMoves; move++) {
-        bool depthReduced = false;
-
-        newdepth = maxdepth;
-
-        board.movePiece(*move);
-        // We are in check after moving
-        if (board.testInCheck(!board.turn)) {
-            // Illegal move, continue
-            board = oldboard;
-            continue;
-        }
-
-        // This move is a check if the move caused the opponent to be in check
-        bool isCheck = board.testInCheck(board.turn);
-
-        int32_t newEval = 0;
-
-        #ifdef ENABLE_CONTEMPT
-        // 3-fold repetition detection
-        if (currdepth > 0 && board.history.isRepeat(board.hash)) {
-            if (currdepth % 2 == 0) newEval = -DRAW_THRESHHOLD;
-            else newEval = 0;
-        } else 
-        #endif
-        {
-            board.history.insert(board.hash);
-
-            // We found a move letting us live next turn
-            foundLegalMove = true;
-
-            movesSearched++;
-
-            if (!inCheck && !move->moveData.isCapture && !isCheck) {
-                newdepth = reduce(currdepth, maxdepth, movesSearched);
-                depthReduced = newdepth != maxdepth;
-            }
-
-            newEval = -recursiveDepthSearch(board, -beta, -alpha, newdepth, currdepth+1);
-
-            if (depthReduced) {
-                if (newEval > alpha) {
-                    // Redo search at full depth
-                    numRedos++;
-                    newdepth = maxdepth;
-                    newEval = -recursiveDepthSearch(board, -beta, -alpha, maxdepth, currdepth+1);
-                }
-            }
-        }
-
-        // Undo move
-        board = oldboard;
-
-        // Prune tree if adjacent branch is already < this branch
-        if (newEval >= beta) {
-            #ifdef ENABLE_TT
-            board.tt->updateEntry(board, *move, beta, maxdepth-currdepth, TT::CUT);
-            #endif
-            #ifdef HISTORY_HEURISTIC
-            int32_t historyBonus = (maxdepth-currdepth)*(maxdepth-currdepth);
-            if (!move->moveData.isCapture) {
-                board.tt->updateHistoryScore(board.turn, *move, historyBonus);
-                for (auto m = moves.begin(); m != move; m++) {
-                    if (!m->moveData.isCapture) {
-                        board.tt->updateHistoryScore(board.turn, *move, -historyBonus/10);
-                    }
-                }
-            }
-            #endif
-            return newEval;
-        }
-
-        if (newEval > bestEval) {
-            bestEval = newEval;
-            bestMove = *move;
-        }
-
-        raisedAlpha |= updatePvs(alpha, move, newEval, currdepth);
-    }
-
-    if (!foundLegalMove && !inCheck) {
-        // Stalemate
-        bestEval = 0;
-    } else if (!foundLegalMove) {
-        // In check but we have no legal moves
-        bestEval = -MATE(currdepth+1);
-    }
-
-    #ifdef ENABLE_TT
-    board.tt->updateEntry(board, bestMove, bestEval, maxdepth-currdepth, raisedAlpha ? TT::PV : TT::ALL);
-    #endif
-    return bestEval;
-}
-
-uint64_t Engine::perft(PerftResult& result, BitBoard& board, uint8_t depth, bool divide) {
-    if (depth == 0 && board.testInCheck(board.turn)) result.checks++;
-    if (depth == 0) {
-        result.nodes++;
-        return 1;
-    }
-
-    using namespace BitBoardState;
-
-    std::array<BitBoard::Move,MAX_MOVES> moves;
-    BitBoard oldboard = board;
-    uint8_t numMoves = board.getAvailableMoves(moves);
-
-    bool foundLegalMove = false;
-    uint64_t nodes = 0;
-
-    for (auto move = moves.begin(); move != moves.begin() + numMoves; move++) {
-        board.movePiece(*move);
-        if (!board.testInCheck(!board.turn)) {
-            foundLegalMove = true;
-            if (depth == 1 && move->promote) result.promotions++;
-            if (depth == 1 && move->moveData.isCapture) result.captures++;
-            if (depth == 1 && move->moveData.isCastle) result.castles++;
-            if (depth == 1 && move->moveData.isEnPassant) result.enpassants++;
-
-            nodes += perft(result, board, depth-1, false);
-            if (divide) {
-                std::cout << BitBoard::moveToStr(*move) << ": " << std::to_string(nodes) << std::endl;
-            }
-        }
-        board = oldboard;
-    }
-
-    if (depth == 1 && !foundLegalMove && board.testInCheck(board.turn)) {
-        result.mates++;
-    }
-
-    return nodes;
-}
-
-void Engine::sendEngineInfo(uint8_t depth) {
-    const auto end = std::chrono::high_resolution_clock::now();
-    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - timeStart);
-    uint32_t evalRate = (time.count() == 0) ? 0 : (uint32_t)(npos / ((float)time.count()/1000));
-
-    std::string evalString;
-    
-    for (uint8_t pv = 0; pv < numPvs; pv++) {
-        if (pvs[pv].eval == NEG_INF) break;
-        
-        if (abs(pvs[pv].eval) >= MATE(MAX_DEPTH)) {
-            if (pvs[pv].eval < 0) {
-                evalString = std::string("mate ").append(std::to_string(-(pvs[pv].eval + BitBoardState::KING_VALUE)/2));
-            } else {
-                evalString = std::string("mate ").append(std::to_string((BitBoardState::KING_VALUE-pvs[pv].eval)/2));
-            }
-        } else {
-            evalString = std::string("cp ").append(std::to_string(pvs[pv].eval));
-        }
-
-        std::string infoString = "info score " + evalString + " depth " + std::to_string(depth)
-                                + " seldepth " + std::to_string(seldepth) + " nodes " + std::to_string(npos) 
-                                + " time " + std::to_string((uint32_t)time.count())
-                                + " nps " + std::to_string(evalRate)
-                                + " multipv " + std::to_string(pv+1) + " pv ";
-        for (uint8_t idx = 0; idx < MAX_DEPTH; idx++) {
-            if (!pvs[pv].moves[idx].valid()) break;
-            infoString += BitBoard::moveToStr(pvs[pv].moves[idx]) + " ";
-        }
-        cmd->uciOutput(infoString);
-    }
-}
-
-void Engine::printSearchStats() const {
-    float branchFactor = std::log2((float)branches)/ std::log2(depthIter-1);
-
-    std::cout << "Searched total number of nodes: " << std::to_string(npos) << std::endl;
-    std::cout << "Branch Factor: " << std::to_string(branchFactor) << std::endl;
-    std::cout << "Aspiration retries: " << std::to_string(aspirationRetries-1) << std::endl;
-    std::cout << "LMR Redo rate: " << std::to_string((float)numRedos*100/numReductions) << "%" << std::endl;
-    std::cout << "TT Hitrate: " << std::to_string((float)numTTHits*100/numTTLookups) << "%" << std::endl;
-    std::cout << "TT Evictionrate: " << std::to_string((float)numTTEvictions*100/numTTLookups) << "%" << std::endl;
-    std::cout << "TT Depth miss: " << std::to_string((float)numTTSoftmiss*100/numTTLookups) << "%" << std::endl;
-    std::cout << "TT Entries filled: " << std::to_string(numTTFills) << std::endl;
-    std::cout << "NULL reduction rate: " << std::to_string((float)numNullReductions*100/branches) << "%" << std::endl;
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "engine.hpp"
+#include "evaluate.hpp"
+#include "movePicker.hpp"
+#include "sohilbot.hpp"
+#include "transpositionTables.hpp"
+
+// Helper threads skip iterations in a staggered pattern so they spread over
+// neighbouring depths instead of repeating the main thread's search
+static constexpr uint8_t SKIP_SIZE[20]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static constexpr uint8_t SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+Engine::~Engine() {
+    delete perftTT;
+    for (Engine* helper : helpers) {
+        delete helper;
+    }
+}
+
+void Engine::setThreads(uint8_t threads) {
+    threads = std::max<uint8_t>(1, std::min<uint8_t>(threads, MAX_THREADS));
+    while (helpers.size() + 1 > threads) {
+        delete helpers.back();
+        helpers.pop_back();
+    }
+    while (helpers.size() + 1 < threads) {
+        helpers.push_back(new Engine(cmd, helpers.size() + 1));
+    }
+}
+
+uint64_t Engine::getNodes() const {
+    uint64_t nodes = npos.load(std::memory_order_relaxed);
+    for (Engine const* helper : helpers) {
+        nodes += helper->npos.load(std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
+int32_t Engine::searchBestMove(BitBoard& board, BitBoard::Move& move, 
+                               uint8_t depth, TimeManager::Limits const& limits)
+{
+    uint8_t const iterStart = 1;
+    int32_t eval = 0;
+    npos = 0;
+    qnodes = 0;
+    branches = 0;
+    numRedos=0;
+    numNullWindows=0;
+    numPvsResearches=0;
+    numBetaCutoffs=0;
+    numFirstMoveCutoffs=0;
+    numReductions=0;
+    numTTLookups=0;
+    numTTHits=0;
+    numTTSoftmiss=0;
+    numTTEvictions=0;
+    numTTFills=0;
+    numNullReductions=0;
+    aspirationRetries=0;
+    seldepth = 0;
+    // Helpers are reset by the main thread before they start, so a stop can't be lost
+    if (!threadId) shouldStop = false;
+
+    depth = std::min(static_cast<int>(depth), MAX_DEPTH-1);
+
+    int32_t alpha = NEG_INF;
+    int32_t beta = INF;
+
+    BitBoard oldBoard = board;
+
+    memset(&currPvs, 0, sizeof(Line)*MAX_PVS);
+    memset(&pvs, 0, sizeof(Line)*MAX_PVS);
+    std::fill(std::begin(stack), std::end(stack), SearchStack());
+    std::fill(&counterMoves[0][0][0], &counterMoves[0][0][0] + 2*7*64, BitBoard::Move());
+
+    // The history table lives in the shared TT, only the main thread resets it
+    if (!threadId) board.tt->clearHistory();
+
+    // Initialize evals to -INF
+    for (uint8_t pv = 0; pv < numPvs; pv++) {
+        pvs[pv].eval = NEG_INF;
+        currPvs[pv].eval = NEG_INF;
+    }
+
+    timeManager.init(limits);
+    nodeLimit = limits.nodes;
+    mateLimit = std::min<uint32_t>(limits.mate, MAX_DEPTH/2);
+    ponder = limits.ponder;
+
+    // Helpers get their own copy of the root and run until the main thread stops them
+    std::vector<std::thread> helperThreads;
+    for (Engine* helper : helpers) {
+        helper->shouldStop = false;
+        helper->npos = 0;
+        helperThreads.emplace_back([helper, board, depth]() mutable {
+            BitBoard::Move helperMove;
+            helper->searchBestMove(board, helperMove, depth, TimeManager::Limits{});
+        });
+    }
+
+    for (depthIter = iterStart; depthIter <= depth; depthIter++) {
+        if (threadId) {
+            uint8_t idx = (threadId - 1) % 20;
+            if (((depthIter + SKIP_PHASE[idx]) / SKIP_SIZE[idx]) % 2) continue;
+        }
+
+        aspirationRetries = 1;
+        numReductions = 0;
+        numNullReductions = 0;
+        numRedos = 0;
+        branches = 0;
+
+        quiesceDepth = std::min(depthIter * 2, MAX_DEPTH-1);
+
+        if (!threadId) board.tt->clearHistory();
+        do {
+            #ifdef ENABLE_ASPIRATION
+            if (aspirationRetries > 2) {
+                // If we tried 2 times, search full window
+                alpha = NEG_INF;
+                beta = INF;
+            } else {
+                if (eval >= beta) beta += ASPIRATION_DELTA * aspirationRetries;
+                if (eval <= alpha) alpha -= ASPIRATION_DELTA * aspirationRetries;
+            }
+            #endif
+            eval = recursiveDepthSearch<true>(board, alpha, beta, depthIter, 0);
+            aspirationRetries++;
+        } while (!shouldStop && (eval > beta || eval < alpha));
+
+        #ifdef ENABLE_ASPIRATION
+        beta = eval + ASPIRATION_START;
+        alpha = eval - ASPIRATION_START;
+        #endif
+
+        for (uint8_t pv = 0; pv < numPvs; pv++) {
+            // Could've stopped before we found all PVs, then don't copy over yet
+            if (currPvs[pv].moves[0].valid()) {
+                memcpy(&pvs[pv], &currPvs[pv], sizeof(Line));
+            }
+        }
+
+        // Ran out of time or got a stop command, left set so a ponder search doesn't wait
+        if (shouldStop) break;
+
+        if (!threadId) sendEngineInfo(depthIter);
+
+        // A mate search goes on until the mate is short enough, mate in n is 2n plies
+        if (mateLimit ? pvs[0].eval >= MATE(2*mateLimit) : abs(eval) > MATE(MAX_DEPTH)) break;
+
+        // Between iterations is where the time manager can stop without losing work. While
+        // pondering, the stop is put off until ponderhit, which may come in at any point here.
+        if (!threadId && timeManager.stopAfterIteration(pvs[0].moves[0], pvs[0].eval)) {
+            if (!isPondering()) break;
+            stopOnPonderhit = true;
+            if (!isPondering()) break;
+        }
+    }
+
+    for (Engine* helper : helpers) {
+        helper->stop();
+    }
+    for (auto& thread : helperThreads) {
+        thread.join();
+    }
+
+    // Out of depth while pondering, the GUI still expects the answer after ponderhit
+    if (!threadId) {
+        std::unique_lock<std::mutex> lock(ponderMutex);
+        ponderWait.wait(lock, [this] { return !isPondering() || shouldStop; });
+    }
+
+    board = oldBoard;
+
+#ifdef SEARCH_STATS_ON
+    if (!threadId) {
+        board.tt->printEstimatedOccupancy();
+        printSearchStats();
+    }
+#endif
+/*
+    std::cout << "History scores  |  Move scores" << std::endl;
+    std::array<BitBoard::Move,MAX_MOVES> moves;
+    uint8_t numMoves = board.getAvailableMoves(moves);
+    board.sortMoves(moves, numMoves, BitBoard::Move());
+    for (uint8_t i = 0; i < numMoves; i++) {
+        std::cout << BitBoard::moveToStr(moves[i]) << ": " << std::to_string(board.tt->getHistoryScore(board.turn, moves[i])) 
+                  << "  |  " << std::to_string(board.estimateMoveValue(moves[i])) << std::endl;
+    }*/
+
+    move = pvs[0].moves[0];
+    if (!move.valid()) {
+        // Stopped before the first root move was searched, any legal move beats none
+        std::array<BitBoard::Move,MAX_MOVES> moves;
+        if (board.getAvailableMoves(moves)) move = moves[0];
+    }
+
+    ponderMove = pvs[0].moves[1];
+    #ifdef ENABLE_TT
+    if (!threadId && !ponderMove.valid() && move.valid()) {
+        // The PV was cut short by a TT hit, the reply may still be in the TT
+        makeMove(board, move, 0);
+        TT::TTEntry entry = board.tt->lookupHash(board.hash);
+        if (entry.hash == board.hash && entry.move.valid() && board.isLegalMove(entry.move)) {
+            ponderMove = entry.move;
+        }
+        unmakeMove(board, move, 0);
+    }
+    #endif
+
+    if (!threadId) {
+        ponderHit = false;
+        stopOnPonderhit = false;
+    }
+    return pvs[0].eval;
+}
+
+// Both flip state under ponderMutex, so a ponder search about to wait can't miss the wakeup
+void Engine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(ponderMutex);
+        shouldStop = true;
+    }
+    ponderWait.notify_all();
+}
+
+void Engine::ponderhit() {
+    {
+        std::lock_guard<std::mutex> lock(ponderMutex);
+        ponderHit = true;
+        // The time manager already wanted to stop while we were pondering
+        if (stopOnPonderhit) shouldStop = true;
+    }
+    ponderWait.notify_all();
+}
+
+// Only the main thread watches the clock and node count, it stops the helpers itself.
+// Every node entry checks shouldStop before it is counted, so a node limited search
+// stops at exactly nodeLimit nodes.
+inline void Engine::checkLimits() {
+    if (threadId) return;
+    uint64_t nodes = npos.load(std::memory_order_relaxed);
+    if ((nodeLimit && nodes >= nodeLimit)
+        || (!(nodes & TIME_CHECK_MASK) && !isPondering() && timeManager.outOfTime())) {
+        shouldStop = true;
+    }
+}
+
+inline void Engine::makeMove(BitBoard& board, BitBoard::Move const& move, uint8_t const ply) {
+    assert(ply < MAX_DEPTH);
+    #ifdef ENABLE_UNMAKE
+    board.makeMove(move, undoStack[ply]);
+    #else
+    boardStack[ply] = board;
+    board.movePiece(move);
+    #endif
+}
+
+inline void Engine::unmakeMove(BitBoard& board, BitBoard::Move const& move, uint8_t const ply) {
+    #ifdef ENABLE_UNMAKE
+    board.unmakeMove(move, undoStack[ply]);
+    #else
+    (void)move;
+    board = boardStack[ply];
+    #endif
+}
+
+inline void Engine::makeNullMove(BitBoard& board, uint8_t const ply) {
+    assert(ply < MAX_DEPTH);
+    #ifdef ENABLE_UNMAKE
+    board.makeNullMove(undoStack[ply]);
+    #else
+    BitBoard::UndoInfo undo;
+    boardStack[ply] = board;
+    board.makeNullMove(undo);
+    #endif
+}
+
+inline void Engine::unmakeNullMove(BitBoard& board, uint8_t const ply) {
+    #ifdef ENABLE_UNMAKE
+    board.unmakeNullMove(undoStack[ply]);
+    #else
+    board = boardStack[ply];
+    #endif
+}
+
+int32_t Engine::quiesce(BitBoard& board, int32_t alpha, int32_t const beta, uint8_t const currdepth,
+                        bool const quietChecks) {
+    using namespace BitBoardState;
+
+    if (shouldStop) return 0;
+
+    countNode();
+    checkLimits();
+    qnodes++;
+    if (currdepth > seldepth) {
+        seldepth = currdepth;
+    }
+
+    // Null move test to see if current position already beats beta
+    int32_t staticEval = Evaluate::evaluatePosition(board);
+    #ifndef ENABLE_QUIESCE
+    return staticEval;
+    #endif
+    if (currdepth == quiesceDepth) return staticEval;
+
+    // Standing pat isn't an option in check, every evasion has to be searched
+    bool inCheck = board.testInCheck(board.turn);
+    int32_t bestEval = inCheck ? -MATE(currdepth+1) : staticEval;
+    if (!inCheck) {
+        if (staticEval >= beta) return staticEval;
+        if (staticEval > alpha) alpha = staticEval;
+    }
+
+    branches++;
+
+    MovePicker picker(board, inCheck, quietChecks);
+    BitBoard::Move move;
+    while (picker.next(move)) {
+        makeMove(board, move, currdepth);
+        int32_t eval = -quiesce(board, -beta, -alpha, currdepth+1);
+        unmakeMove(board, move, currdepth);
+        if (shouldStop) return 0;
+
+        if (eval >= beta) return eval;
+        if (eval > alpha) alpha = eval;
+        if (eval > bestEval) bestEval = eval;
+    }
+
+    return bestEval;
+}
+
+inline void Engine::extendSearch(uint8_t& depth, bool inCheck) const {
+    if (depth >= quiesceDepth) return;
+    if (depth < quiesceDepth-1 && inCheck) depth+=2;
+}
+
+inline uint8_t Engine::reduce(uint8_t const currdepth, uint8_t const maxdepth, uint8_t movesSearched) {
+    uint8_t newdepth = maxdepth;
+    #ifdef ENABLE_LMR
+    // Reduce late moves if we can
+    if (currdepth + 1 < maxdepth) {
+        if ((movesSearched > LATE_MOVE_CUTOFF)) {
+            if (currdepth < REDUCE1(maxdepth)) newdepth=REDUCE1(maxdepth);
+            else newdepth = maxdepth-1;
+            numReductions++;
+        } else if ((movesSearched > LATE_MOVE_CUTOFF_2)) {
+            if (currdepth < REDUCE2(maxdepth)) newdepth=REDUCE2(maxdepth);
+            else newdepth = maxdepth-1;
+            numReductions++;
+        }
+    }
+    #endif
+    return newdepth;
+}
+
+// New best move at a PV node: its line is the move followed by the child's line
+inline void Engine::updatePv(BitBoard::Move const& move, uint8_t const ply) {
+    pvTable[ply][ply] = move;
+    for (uint8_t idx = ply+1; idx < pvLength[ply+1]; idx++) {
+        pvTable[ply][idx] = pvTable[ply+1][idx];
+    }
+    pvLength[ply] = std::max<uint8_t>(pvLength[ply+1], ply+1);
+}
+
+inline bool Engine::updateRootPvs(int32_t& alpha, BitBoard::Move const& move, int32_t newEval) {
+    bool raisedAlpha = false;
+
+    for (uint8_t pv = 0; pv < numPvs; pv++) {
+        if (newEval > currPvs[pv].eval) {
+            // Shift all pvs after this one down
+            for (uint8_t sft = numPvs-1; sft > pv; sft--) {
+                currPvs[sft] = currPvs[sft-1];
+            }
+            Line& line = currPvs[pv];
+            line.eval = newEval;
+            line.moves[0] = move;
+            uint8_t length = std::max<uint8_t>(pvLength[1], 1);
+            for (uint8_t idx = 1; idx < length; idx++) {
+                line.moves[idx] = pvTable[1][idx];
+            }
+            if (length < MAX_DEPTH) line.moves[length] = BitBoard::Move();
+            break;
+        }
+    }
+
+    if (numPvs > 1) {
+        raisedAlpha = true;
+        // For MultiPV, we want a wider window from the root node so we don't beta-cutoff other PVs
+        alpha = currPvs[numPvs-1].eval;
+    } else {
+        if (newEval > alpha) {
+            alpha = newEval;
+            raisedAlpha = true;
+        }
+    }
+
+    return raisedAlpha;
+}
+
+template<bool PvNode>
+int32_t Engine::recursiveDepthSearch(BitBoard& board,
+                                     int32_t alpha, int32_t beta, 
+                                     uint8_t maxdepth, uint8_t const currdepth)
+{
+    using namespace BitBoardState;
+
+    if (shouldStop) {
+        return NEG_INF;
+    }
+    
+    if (PvNode) pvLength[currdepth] = currdepth;
+    if (currdepth == 0) {
+        for (uint8_t pv = 0; pv < numPvs; pv++) {
+            currPvs[pv].eval = NEG_INF;
+            currPvs[pv].moves[0] = BitBoard::Move();
+        }
+    }
+
+    // Check the TT for hits
+    BitBoard::Move ttMove = BitBoard::Move();
+    #ifdef ENABLE_TT
+    TT::TTEntry entry = board.tt->lookupHash(board.hash);
+    numTTLookups++;
+    if (entry.hash == board.hash) {
+        ttMove = entry.move;
+        // PV nodes, the root among them, always search and only use the TT move for ordering.
+        // A stored score may come from an older search that didn't see this game's repetitions,
+        // and cutting off here would leave a one move PV.
+        if (!PvNode && entry.depth >= (maxdepth-currdepth)) {
+            numTTHits++;
+            if (entry.node == TT::PV || (entry.node == TT::ALL && entry.eval < alpha)) {
+                return entry.eval;
+            } else if (entry.node == TT::CUT && entry.eval >= beta) {
+                return entry.eval;
+            }
+        } else {
+            numTTSoftmiss++;
+        }
+    } else {
+        if (entry.hash == 0) numTTFills++;
+        else numTTEvictions++;
+    }
+    #endif
+
+    // Base case
+    if (currdepth == maxdepth) {
+        // Quiet checks only on the first quiescence ply, deeper they blow up the tree
+        int32_t eval = quiesce(board, alpha, beta, currdepth, true);
+        if (shouldStop) return 0;
+
+        // Leaf of search tree is PV node
+        board.tt->updateEntry(board, BitBoard::Move(), eval, 0, TT::PV);
+
+        return eval;
+    }
+
+    countNode();
+    checkLimits();
+    branches++;
+
+    bool inCheck = board.testInCheck(board.turn);
+    // Increase depth of search while still in check
+    if (currdepth == maxdepth - 1) extendSearch(maxdepth, inCheck);
+    uint8_t newdepth = maxdepth;
+
+#ifdef ENABLE_NULL_MOVE
+    if ((currdepth+3 < maxdepth) && !inCheck && board.moves < ENDGAME_CUTOFF) {
+        // Null move reduction: try a Null move and use it to reduce search depth
+        stack[currdepth].currentMove = BitBoard::Move();
+        makeNullMove(board, currdepth);
+        newdepth = currdepth+3;
+        int32_t eval = -recursiveDepthSearch<false>(board, -beta, -beta+1, newdepth, currdepth+1);
+        unmakeNullMove(board, currdepth);
+        if (shouldStop) return 0;
+        if (eval >= beta) {
+            numNullReductions++;
+            if (currdepth < REDUCE1(maxdepth)) {
+                newdepth=REDUCE1(maxdepth);
+            } else {
+                // Doing nothing is already better for us than making a move, just return beta
+                board.tt->updateEntry(board, BitBoard::Move(), beta, maxdepth-currdepth, TT::CUT);
+                return beta;
+            }
+        }
+    }
+#endif
+
+    bool foundLegalMove = false;
+    bool raisedAlpha = false;
+    int32_t bestEval = NEG_INF;
+    BitBoard::Move bestMove = BitBoard::Move();
+
+    #ifdef HISTORY_HEURISTIC
+    std::array<BitBoard::Move,MAX_MOVES> quietsSearched;
+    uint8_t numQuietsSearched = 0;
+    #endif
+
+    // The opponent's last move picks the countermove, unless it was a null move
+    SearchStack& ss = stack[currdepth];
+    SearchStack const* prev = (currdepth > 0 && stack[currdepth-1].currentMove.valid()) ? &stack[currdepth-1] : nullptr;
+    BitBoard::Move counterMove = prev ? counterMoves[!board.turn][prev->movedPiece][prev->currentMove.to()]
+                                      : BitBoard::Move();
+
+    MovePicker picker(board, ttMove, ss.killers, counterMove, inCheck);
+    BitBoard::Move move;
+
+    uint8_t movesSearched = 0;
+    while (picker.next(move)) {
+        bool depthReduced = false;
+
+        newdepth = maxdepth;
+
+        ss.currentMove = move;
+        ss.movedPiece = board.pieceOn[move.from()];
+        // Children that aren't searched as PV nodes (or at all) leave no line behind
+        if (PvNode) pvLength[currdepth+1] = currdepth+1;
+        makeMove(board, move, currdepth);
+
+        // This move is a check if the move caused the opponent to be in check
+        bool isCheck = board.testInCheck(board.turn);
+
+        int32_t newEval = 0;
+
+        #ifdef ENABLE_CONTEMPT
+        // 3-fold repetition detection
+        if (currdepth > 0 && board.history.isRepeat(board.hash)) {
+            if (currdepth % 2 == 0) newEval = -DRAW_THRESHHOLD;
+            else newEval = 0;
+        } else 
+        #endif
+        {
+            uint64_t evicted = board.history.insert(board.hash);
+
+            // We found a move letting us live next turn
+            foundLegalMove = true;
+
+            movesSearched++;
+
+            if (!inCheck && !move.isCapture() && !isCheck) {
+                newdepth = reduce(currdepth, maxdepth, movesSearched);
+                depthReduced = newdepth != maxdepth;
+            }
+
+            if (movesSearched == 1) {
+                // The first move is expected to be best, it is searched like this node
+                newEval = -recursiveDepthSearch<PvNode>(board, -beta, -alpha, newdepth, currdepth+1);
+            } else {
+                // Later moves only have to show they're no better than alpha
+                numNullWindows++;
+                newEval = -recursiveDepthSearch<false>(board, -alpha-1, -alpha, newdepth, currdepth+1);
+
+                if (depthReduced && newEval > alpha) {
+                    // Redo search at full depth
+                    numRedos++;
+                    newEval = -recursiveDepthSearch<false>(board, -alpha-1, -alpha, maxdepth, currdepth+1);
+                }
+
+                // Beat alpha without failing high, get the exact score and line with a full window
+                if (PvNode && newEval > alpha && newEval < beta) {
+                    numPvsResearches++;
+                    newEval = -recursiveDepthSearch<true>(board, -beta, -alpha, maxdepth, currdepth+1);
+                }
+            }
+            board.history.undo(evicted);
+        }
+
+        // Undo move
+        unmakeMove(board, move, currdepth);
+
+        // A search cut short by a stop returns garbage, keep it out of the TT, killers and PVs
+        if (shouldStop) return 0;
+
+        // Prune tree if adjacent branch is already < this branch
+        if (newEval >= beta) {
+            #ifdef ENABLE_TT
+            board.tt->updateEntry(board, move, beta, maxdepth-currdepth, TT::CUT);
+            #endif
+            numBetaCutoffs++;
+            numFirstMoveCutoffs += movesSearched == 1;
+            if (!move.isCapture()) {
+                // Quiet move that refuted this node, try it early in sibling nodes
+                if (!(ss.killers[0] == move)) {
+                    ss.killers[1] = ss.killers[0];
+                    ss.killers[0] = move;
+                }
+                // and whenever the opponent plays the same move again
+                if (prev) counterMoves[!board.turn][prev->movedPiece][prev->currentMove.to()] = move;
+                #ifdef HISTORY_HEURISTIC
+                int32_t historyBonus = (maxdepth-currdepth)*(maxdepth-currdepth);
+                board.tt->updateHistoryScore(board.turn, move, historyBonus);
+                for (uint8_t i = 0; i < numQuietsSearched; i++) {
+                    board.tt->updateHistoryScore(board.turn, quietsSearched[i], -historyBonus/10);
+                }
+                #endif
+            }
+            return newEval;
+        }
+
+        #ifdef HISTORY_HEURISTIC
+        if (!move.isCapture()) quietsSearched[numQuietsSearched++] = move;
+        #endif
+
+        if (newEval > bestEval) {
+            bestEval = newEval;
+            bestMove = move;
+            if (PvNode && currdepth) updatePv(move, currdepth);
+        }
+
+        if (currdepth == 0) {
+            raisedAlpha |= updateRootPvs(alpha, move, newEval);
+        } else if (newEval > alpha) {
+            alpha = newEval;
+            raisedAlpha = true;
+        }
+    }
+
+    if (!foundLegalMove && !inCheck) {
+        // Stalemate
+        bestEval = 0;
+    } else if (!foundLegalMove) {
+        // In check but we have no legal moves
+        bestEval = -MATE(currdepth+1);
+    }
+
+    #ifdef ENABLE_TT
+    board.tt->updateEntry(board, bestMove, bestEval, maxdepth-currdepth, raisedAlpha ? TT::PV : TT::ALL);
+    #endif
+    return bestEval;
+}
+
+// 0 turns the perft hash off
+void Engine::setPerftHash(size_t megabytes) {
+    if (perftTT && perftTT->getSizeMb() == megabytes) return;
+    delete perftTT;
+    perftTT = megabytes ? new PerftTT(megabytes) : nullptr;
+}
+
+// Perft runs on several threads at once, so it can't use the engine's per-ply stacks.
+// The caller keeps the undo state, which is a whole board copy without ENABLE_UNMAKE.
+#ifdef ENABLE_UNMAKE
+typedef BitBoard::UndoInfo PerftUndo;
+static inline void perftMake(BitBoard& board, BitBoard::Move const& move, PerftUndo& undo) {
+    board.makeMove(move, undo);
+}
+static inline void perftUnmake(BitBoard& board, BitBoard::Move const& move, PerftUndo const& undo) {
+    board.unmakeMove(move, undo);
+}
+#else
+typedef BitBoard PerftUndo;
+static inline void perftMake(BitBoard& board, BitBoard::Move const& move, PerftUndo& undo) {
+    undo = board;
+    board.movePiece(move);
+}
+static inline void perftUnmake(BitBoard& board, BitBoard::Move const& move, PerftUndo const& undo) {
+    (void)move;
+    board = undo;
+}
+#endif
+
+// Root of perft. Root moves are handed out to the worker threads, split one ply
+// further when there aren't enough of them to keep every thread busy.
+uint64_t Engine::perft(PerftResult& result, BitBoard& board, uint8_t depth, bool divide, bool bulk, uint8_t threads) {
+    // A piece of the tree for one thread, the root move and possibly a reply to it
+    struct PerftTask {
+        BitBoard::Move moves[2];
+        uint8_t numMoves;
+        uint8_t root;
+        uint64_t nodes;
+    };
+
+    // Start every run from an empty table so hit rates and timings are comparable
+    if (perftTT) perftTT->clear();
+
+    // Leaf statistics are counted one ply above the leaves, so the root has to
+    // stay in this thread for the shallowest depths
+    if (depth < 2 || (!divide && threads <= 1)) {
+        if (divide && depth == 1) {
+            // Every root move is a single leaf, in generator order like the deeper divides
+            std::array<BitBoard::Move,MAX_MOVES> rootMoves;
+            uint8_t numRootMoves = board.getAvailableMoves(rootMoves);
+            for (uint8_t i = 0; i < numRootMoves; i++) {
+                std::cout << BitBoard::moveToStr(rootMoves[i]) << ": 1" << std::endl;
+            }
+        }
+        PerftHashStats hashStats{};
+        uint64_t nodes = perftSubtree(result, board, depth, bulk && !divide, perftTT, hashStats);
+        if (perftTT) perftTT->addStats(hashStats.probes, hashStats.hits);
+        return nodes;
+    }
+
+    std::array<BitBoard::Move,MAX_MOVES> rootMoves;
+    uint8_t numRootMoves = board.getAvailableMoves(rootMoves);
+
+    std::vector<PerftTask> tasks;
+    bool split = threads > 1 && numRootMoves < threads && depth >= 3;
+    for (uint8_t i = 0; i < numRootMoves; i++) {
+        if (!split) {
+            tasks.push_back({{rootMoves[i], BitBoard::Move()}, 1, i, 0});
+            continue;
+        }
+        PerftUndo undo;
+        std::array<BitBoard::Move,MAX_MOVES> replies;
+        perftMake(board, rootMoves[i], undo);
+        uint8_t numReplies = board.getAvailableMoves(replies);
+        perftUnmake(board, rootMoves[i], undo);
+        for (uint8_t j = 0; j < numReplies; j++) {
+            tasks.push_back({{rootMoves[i], replies[j]}, 2, i, 0});
+        }
+    }
+
+    // Every thread counts into locals and hands them over once at the end, so threads
+    // never write to a shared cache line per node. Merged after the join.
+    std::vector<PerftResult> threadResults(std::max<uint8_t>(threads, 1), PerftResult{});
+    std::vector<PerftHashStats> threadHashStats(std::max<uint8_t>(threads, 1), PerftHashStats{});
+    std::atomic<uint32_t> nextTask(0);
+    auto worker = [&](uint8_t id) {
+        PerftResult counted{};
+        PerftHashStats hashStats{};
+        for (uint32_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+            PerftTask& task = tasks[i];
+            BitBoard child = board;
+            PerftUndo undo[2];
+            for (uint8_t m = 0; m < task.numMoves; m++) {
+                perftMake(child, task.moves[m], undo[m]);
+            }
+            task.nodes = perftSubtree(counted, child, depth - task.numMoves, bulk, perftTT, hashStats);
+        }
+        threadResults[id] = counted;
+        threadHashStats[id] = hashStats;
+    };
+
+    std::vector<std::thread> pool;
+    for (uint8_t id = 1; id < threads; id++) {
+        pool.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (auto const& threadResult : threadResults) {
+        result += threadResult;
+    }
+    if (perftTT) {
+        for (auto const& hashStats : threadHashStats) {
+            perftTT->addStats(hashStats.probes, hashStats.hits);
+        }
+    }
+
+    // Tasks are in root move order, so divide output doesn't depend on scheduling
+    uint64_t nodes = 0;
+    for (uint32_t i = 0; i < tasks.size();) {
+        uint8_t root = tasks[i].root;
+        uint64_t rootNodes = 0;
+        for (; i < tasks.size() && tasks[i].root == root; i++) {
+            rootNodes += tasks[i].nodes;
+        }
+        if (divide) {
+            std::cout << BitBoard::moveToStr(rootMoves[root]) << ": " << std::to_string(rootNodes) << std::endl;
+        }
+        nodes += rootNodes;
+    }
+
+    return nodes;
+}
+
+// Plain recursive perft, only touches the board it's given so threads can run it side by side
+uint64_t Engine::perftSubtree(PerftResult& result, BitBoard& board, uint8_t depth, bool bulk, PerftTT* ptt,
+                              PerftHashStats& hashStats) {
+    if (depth == 0 && board.testInCheck(board.turn)) result.checks++;
+    if (depth == 0) {
+        result.nodes++;
+        return 1;
+    }
+
+    using namespace BitBoardState;
+
+    // Subtrees reached again through a transposition are added straight from the
+    // table. The last ply is cheaper to count than to look up.
+    bool hashed = ptt && depth >= 2;
+    PerftResult subtree;
+    if (hashed) {
+        hashStats.probes++;
+        if (ptt->probe(board.hash, depth, bulk, subtree)) {
+            hashStats.hits++;
+            result += subtree;
+            return subtree.nodes;
+        }
+        subtree = result;
+    }
+
+    std::array<BitBoard::Move,MAX_MOVES> moves;
+    uint8_t numMoves = board.getAvailableMoves(moves);
+    uint64_t nodes = 0;
+
+    if (depth == 1) {
+        for (auto move = moves.begin(); move != moves.begin() + numMoves; move++) {
+            if (move->isPromotion()) result.promotions++;
+            if (move->isCapture()) result.captures++;
+            if (move->isCastle()) result.castles++;
+            if (move->isEnPassant()) result.enpassants++;
+        }
+        if (!numMoves && board.testInCheck(board.turn)) result.mates++;
+
+        // Every generated move is legal, so the leaves can be counted without playing them.
+        // Checks are only known after the move is made, so bulk counting skips them.
+        if (bulk) {
+            result.nodes += numMoves;
+            return numMoves;
+        }
+    }
+
+    PerftUndo undo;
+    for (auto move = moves.begin(); move != moves.begin() + numMoves; move++) {
+        perftMake(board, *move, undo);
+        nodes += perftSubtree(result, board, depth-1, bulk, ptt, hashStats);
+        perftUnmake(board, *move, undo);
+    }
+
+    if (hashed) {
+        PerftResult counted = result;
+        counted -= subtree;
+        ptt->store(board.hash, depth, bulk, counted);
+    }
+
+    return nodes;
+}
+
+void Engine::sendEngineInfo(uint8_t depth) {
+    uint32_t time = timeManager.elapsed();
+    uint64_t nodes = getNodes();
+    uint32_t evalRate = (time == 0) ? 0 : (uint32_t)(nodes / ((float)time/1000));
+
+    std::string evalString;
+    
+    for (uint8_t pv = 0; pv < numPvs; pv++) {
+        if (pvs[pv].eval == NEG_INF) break;
+        
+        if (abs(pvs[pv].eval) >= MATE(MAX_DEPTH)) {
+            if (pvs[pv].eval < 0) {
+                evalString = std::string("mate ").append(std::to_string(-(pvs[pv].eval + BitBoardState::KING_VALUE)/2));
+            } else {
+                evalString = std::string("mate ").append(std::to_string((BitBoardState::KING_VALUE-pvs[pv].eval)/2));
+            }
+        } else {
+            evalString = std::string("cp ").append(std::to_string(pvs[pv].eval));
+        }
+
+        std::string infoString = "info score " + evalString + " depth " + std::to_string(depth)
+                                + " seldepth " + std::to_string(seldepth) + " nodes " + std::to_string(nodes) 
+                                + " time " + std::to_string(time)
+                                + " nps " + std::to_string(evalRate)
+                                + " multipv " + std::to_string(pv+1) + " pv ";
+        for (uint8_t idx = 0; idx < MAX_DEPTH; idx++) {
+            if (!pvs[pv].moves[idx].valid()) break;
+            infoString += BitBoard::moveToStr(pvs[pv].moves[idx]) + " ";
+        }
+        cmd->uciOutput(infoString);
+    }
+}
+
+void Engine::printSearchStats() const {
+    float branchFactor = std::log2((float)branches)/ std::log2(depthIter-1);
+
+    std::cout << "Searched total number of nodes: " << std::to_string(getNodes()) << std::endl;
+    std::cout << "Quiescence nodes: " << std::to_string(qnodes) << std::endl;
+    std::cout << "Branch Factor: " << std::to_string(branchFactor) << std::endl;
+    std::cout << "Aspiration retries: " << std::to_string(aspirationRetries-1) << std::endl;
+    std::cout << "LMR Redo rate: " << std::to_string((float)numRedos*100/numReductions) << "%" << std::endl;
+    std::cout << "PVS Re-search rate: " << std::to_string((float)numPvsResearches*100/numNullWindows) << "%" << std::endl;
+    std::cout << "First move cutoff rate: " << std::to_string((float)numFirstMoveCutoffs*100/numBetaCutoffs) << "%" << std::endl;
+    std::cout << "TT Hitrate: " << std::to_string((float)numTTHits*100/numTTLookups) << "%" << std::endl;
+    std::cout << "TT Evictionrate: " << std::to_string((float)numTTEvictions*100/numTTLookups) << "%" << std::endl;
+    std::cout << "TT Depth miss: " << std::to_string((float)numTTSoftmiss*100/numTTLookups) << "%" << std::endl;
+    std::cout << "TT Entries filled: " << std::to_string(numTTFills) << std::endl;
+    std::cout << "NULL reduction rate: " << std::to_string((float)numNullReductions*100/branches) << "%" << std::endl;
 }
\ No newline at end of file
@@ -1,99 +1,194 @@
-#ifndef __ENGINE_INC_GUARD__
-#define __ENGINE_INC_GUARD__
-
-#include "bitboard.hpp"
-#include <array>
-#include <chrono>
-#include "sohilbot.hpp"
-
-class Engine {
-    public:
-        struct PerftResult {
-            uint64_t nodes;
-            uint64_t captures;
-            uint64_t enpassants;
-            uint64_t castles;
-            uint64_t promotions;
-            uint64_t checks;
-            uint64_t mates;
-
-            bool operator==(const PerftResult& other) const {
-                return nodes == other.nodes &&
-                       captures == other.captures &&
-                       enpassants == other.enpassants &&
-                       castles == other.castles &&
-                       promotions == other.promotions &&
-                       checks == other.checks &&
-                       mates == other.mates;
-            }
-
-            friend std::ostream& operator<<(std::ostream& os, const PerftResult& result) {
-                os << "{" << std::endl;
-                os << "    nodes:       " << result.nodes << std::endl;
-                os << "    captures:    " << result.captures << std::endl;
-                os << "    enpassants:  " << result.enpassants << std::endl;
-                os << "    castles:     " << result.castles << std::endl;
-                os << "    promotions:  " << result.promotions << std::endl;
-                os << "    checks:      " << result.checks << std::endl;
-                os << "    mates:       " << result.mates << std::endl;
-                os << "}" << std::endl;
-                return os;
-            }
-        };
-
-        Engine(SohilBot* pSohilBot) : cmd(pSohilBot) { };
-        ~Engine() { };
-
-        int32_t searchBestMove(BitBoard& board, BitBoard::Move& move, 
-                               uint8_t depth, uint32_t time);
-        uint64_t perft(PerftResult& result, BitBoard& board, uint8_t depth, bool divide=true);
-        void stop() { shouldStop = true; };
-        void setNumPvs(uint8_t pvs) { numPvs = pvs; }
-
-    private:
-        struct Line {
-            std::array<BitBoard::Move, MAX_DEPTH> moves;
-            int32_t eval;
-        };
-
-        int32_t recursiveDepthSearch(BitBoard& board,
-                                     int32_t alpha, int32_t beta, 
-                                     uint8_t maxdepth, uint8_t const currdepth);
-        int32_t searchPv(BitBoard& board,
-                         int32_t alpha, int32_t const beta, 
-                         uint8_t const maxdepth, uint8_t const currdepth);
-        int32_t quiesce(BitBoard& board, int32_t alpha, int32_t const beta, uint8_t const currdepth);
-
-        void sendEngineInfo(uint8_t depth);
-        void printSearchStats() const;
-        void extendSearch(uint8_t& depth, bool inCheck) const;
-        uint8_t reduce(uint8_t const currdepth, uint8_t const maxdepth, uint8_t movesSearched);
-        bool updatePvs(int32_t& alpha, BitBoard::Move* move,
-                       int32_t newEval, uint8_t const currdepth);
-
-        struct Line currPvs[MAX_PVS][MAX_DEPTH];
-        struct Line pvs[MAX_PVS];
-
-        uint64_t npos;
-        uint64_t branches;
-        uint32_t numRedos=0;
-        uint32_t numReductions=0;
-        uint32_t numTTLookups=0;
-        uint32_t numTTHits=0;
-        uint32_t numTTSoftmiss=0;
-        uint32_t numTTEvictions=0;
-        uint32_t numTTFills=0;
-        uint32_t numNullReductions=0;
-        uint32_t aspirationRetries=0;
-        uint8_t depthIter=0;
-        uint8_t seldepth=0;
-        uint8_t quiesceDepth=0;
-        uint32_t timelimit=3000;
-        std::chrono::time_point<std::chrono::steady_clock> timeStart;
-        float prevTime;
-        std::atomic<bool> shouldStop;
-        uint8_t numPvs=1;
-        SohilBot* cmd;
-};
-
+#ifndef __ENGINE_INC_GUARD__
+#define __ENGINE_INC_GUARD__
+
+#include "bitboard.hpp"
+#include <array>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "sohilbot.hpp"
+#include "timeManager.hpp"
+
+class PerftTT;
+
+class Engine {
+    public:
+        struct PerftResult {
+            uint64_t nodes;
+            uint64_t captures;
+            uint64_t enpassants;
+            uint64_t castles;
+            uint64_t promotions;
+            uint64_t checks;
+            uint64_t mates;
+
+            PerftResult& operator+=(const PerftResult& other) {
+                nodes += other.nodes;
+                captures += other.captures;
+                enpassants += other.enpassants;
+                castles += other.castles;
+                promotions += other.promotions;
+                checks += other.checks;
+                mates += other.mates;
+                return *this;
+            }
+
+            PerftResult& operator-=(const PerftResult& other) {
+                nodes -= other.nodes;
+                captures -= other.captures;
+                enpassants -= other.enpassants;
+                castles -= other.castles;
+                promotions -= other.promotions;
+                checks -= other.checks;
+                mates -= other.mates;
+                return *this;
+            }
+
+            bool operator==(const PerftResult& other) const {
+                return nodes == other.nodes &&
+                       captures == other.captures &&
+                       enpassants == other.enpassants &&
+                       castles == other.castles &&
+                       promotions == other.promotions &&
+                       checks == other.checks &&
+                       mates == other.mates;
+            }
+
+            friend std::ostream& operator<<(std::ostream& os, const PerftResult& result) {
+                os << "{" << std::endl;
+                os << "    nodes:       " << result.nodes << std::endl;
+                os << "    captures:    " << result.captures << std::endl;
+                os << "    enpassants:  " << result.enpassants << std::endl;
+                os << "    castles:     " << result.castles << std::endl;
+                os << "    promotions:  " << result.promotions << std::endl;
+                os << "    checks:      " << result.checks << std::endl;
+                os << "    mates:       " << result.mates << std::endl;
+                os << "}" << std::endl;
+                return os;
+            }
+        };
+
+        Engine(SohilBot* pSohilBot, uint8_t id=0) : cmd(pSohilBot), threadId(id) { };
+        ~Engine();
+
+        int32_t searchBestMove(BitBoard& board, BitBoard::Move& move, 
+                               uint8_t depth, TimeManager::Limits const& limits);
+        uint64_t perft(PerftResult& result, BitBoard& board, uint8_t depth, bool divide=true, bool bulk=false,
+                       uint8_t threads=1);
+        void setPerftHash(size_t megabytes);
+        PerftTT const* getPerftHash() const { return perftTT; }
+        void stop();
+        void ponderhit();
+        BitBoard::Move getPonderMove() const { return ponderMove; }
+        void setNumPvs(uint8_t pvs) { numPvs = pvs; }
+        void setThreads(uint8_t threads);
+        uint64_t getNodes() const;
+
+    private:
+        struct Line {
+            std::array<BitBoard::Move, MAX_DEPTH> moves;
+            int32_t eval;
+        };
+
+        // Principal variation search. PV nodes get an open window, every other node is
+        // searched with a null window around alpha and only proves a move fails low or high.
+        template<bool PvNode>
+        int32_t recursiveDepthSearch(BitBoard& board,
+                                     int32_t alpha, int32_t beta, 
+                                     uint8_t maxdepth, uint8_t const currdepth);
+        // Perft hash probes and hits, counted by each thread on its own
+        struct PerftHashStats {
+            uint64_t probes;
+            uint64_t hits;
+        };
+
+        static uint64_t perftSubtree(PerftResult& result, BitBoard& board, uint8_t depth, bool bulk, PerftTT* ptt,
+                                     PerftHashStats& hashStats);
+        int32_t quiesce(BitBoard& board, int32_t alpha, int32_t const beta, uint8_t const currdepth,
+                        bool const quietChecks=false);
+
+        void sendEngineInfo(uint8_t depth);
+        void printSearchStats() const;
+        void extendSearch(uint8_t& depth, bool inCheck) const;
+        uint8_t reduce(uint8_t const currdepth, uint8_t const maxdepth, uint8_t movesSearched);
+        void updatePv(BitBoard::Move const& move, uint8_t const ply);
+        bool updateRootPvs(int32_t& alpha, BitBoard::Move const& move, int32_t newEval);
+        // Only the owning thread writes its node count, the main thread reads it for info output
+        void countNode() { npos.store(npos.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+        void checkLimits();
+        bool isPondering() const { return ponder && !ponderHit; }
+        void makeMove(BitBoard& board, BitBoard::Move const& move, uint8_t const ply);
+        void unmakeMove(BitBoard& board, BitBoard::Move const& move, uint8_t const ply);
+        void makeNullMove(BitBoard& board, uint8_t const ply);
+        void unmakeNullMove(BitBoard& board, uint8_t const ply);
+
+        // Triangular PV table, row ply holds the best line from ply on in its columns
+        // [ply, pvLength[ply]). Only PV nodes keep lines, non-PV nodes never pass theirs up.
+        BitBoard::Move pvTable[MAX_DEPTH][MAX_DEPTH];
+        uint8_t pvLength[MAX_DEPTH];
+        // Root lines of the iteration in progress, best first, and of the last finished one
+        struct Line currPvs[MAX_PVS];
+        struct Line pvs[MAX_PVS];
+
+        // Per ply state of the search, indexed by currdepth
+        struct SearchStack {
+            BitBoard::Move killers[2];      // Two most recent quiet beta cutoffs, tried after the good captures
+            BitBoard::Move currentMove;     // Move being searched from this ply, invalid for a null move
+            BitBoardState::Piece movedPiece;
+        };
+        SearchStack stack[MAX_DEPTH];
+        // Quiet move that last refuted a move, by the refuted side, piece and destination square
+        BitBoard::Move counterMoves[2][7][64];
+
+        #ifdef ENABLE_UNMAKE
+        BitBoard::UndoInfo undoStack[MAX_DEPTH];
+        #else
+        BitBoard boardStack[MAX_DEPTH];
+        #endif
+
+        std::atomic<uint64_t> npos;
+        uint64_t qnodes;
+        uint64_t branches;
+        uint32_t numRedos=0;
+        uint32_t numNullWindows=0;
+        uint32_t numPvsResearches=0;
+        uint32_t numBetaCutoffs=0;
+        uint32_t numFirstMoveCutoffs=0;
+        uint32_t numReductions=0;
+        uint32_t numTTLookups=0;
+        uint32_t numTTHits=0;
+        uint32_t numTTSoftmiss=0;
+        uint32_t numTTEvictions=0;
+        uint32_t numTTFills=0;
+        uint32_t numNullReductions=0;
+        uint32_t aspirationRetries=0;
+        uint8_t depthIter=0;
+        uint8_t seldepth=0;
+        uint8_t quiesceDepth=0;
+        TimeManager timeManager;
+        uint64_t nodeLimit=0;
+        uint8_t mateLimit=0;
+        // A ponder search ignores the clock until ponderhit, and never returns before
+        // ponderhit or stop. ponderHit is only cleared once the search is over, so a
+        // ponderhit that arrives before the search has started isn't lost.
+        bool ponder=false;
+        std::atomic<bool> ponderHit{false};
+        std::atomic<bool> stopOnPonderhit{false};
+        // A ponder search that is done waits here for ponderhit or stop
+        std::mutex ponderMutex;
+        std::condition_variable ponderWait;
+        BitBoard::Move ponderMove;
+        std::atomic<bool> shouldStop;
+        uint8_t numPvs=1;
+        SohilBot* cmd;
+        PerftTT* perftTT=nullptr;
+
+        // Lazy SMP. The main engine (thread 0) owns helper engines with their own board,
+        // stacks and PVs that search the same root and only share the TT.
+        uint8_t threadId;
+        std::vector<Engine*> helpers;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "movePicker.hpp"
+#include "transpositionTables.hpp"
+
+using namespace BitBoardState;
+
+MovePicker::MovePicker(BitBoard const& _board, BitBoard::Move const& _ttMove, BitBoard::Move const* _killers,
+                       BitBoard::Move const& _counterMove, bool _inCheck)
+    : board(_board), ttMove(_ttMove), counterMove(_counterMove), stage(TT_MOVE), capturesOnly(false),
+      inCheck(_inCheck), quietChecks(false),
+      cur(0), numCaptures(0), badCaptures(0), numMoves(0), killerIdx(0), checksLeft(0)
+{
+    killers[0] = _killers[0];
+    killers[1] = _killers[1];
+}
+
+MovePicker::MovePicker(BitBoard const& _board, bool _inCheck, bool _quietChecks)
+    : board(_board), ttMove(), counterMove(), stage(_inCheck ? GEN_EVASIONS : GEN_CAPTURES), capturesOnly(true),
+      inCheck(_inCheck), quietChecks(_quietChecks), cur(0), numCaptures(0), badCaptures(0), numMoves(0),
+      killerIdx(0), checksLeft(QUIESCE_CHECK_BUDGET)
+{
+}
+
+bool MovePicker::next(BitBoard::Move& move) {
+    while (true) {
+        switch (stage) {
+            case TT_MOVE:
+                stage = inCheck ? GEN_EVASIONS : GEN_CAPTURES;
+                // The TT move came from a position with the same hash, but still has to be checked
+                if (ttMove.valid() && board.isLegalMove(ttMove)) {
+                    move = ttMove;
+                    return true;
+                }
+                ttMove = BitBoard::Move();
+                break;
+
+            case GEN_CAPTURES:
+                numCaptures = board.getAvailableMoves(moves.data(), BitBoard::CAPTURES);
+                badCaptures = numCaptures;
+                numMoves = numCaptures;
+                scoreCaptures();
+                cur = 0;
+                stage = GOOD_CAPTURES;
+                break;
+
+            case GOOD_CAPTURES:
+                while (cur < numCaptures) {
+                    move = pickBest(numCaptures);
+                    if (scores[cur] < 0) {
+                        // Everything left loses material, try it after the quiets
+                        badCaptures = cur;
+                        break;
+                    }
+                    cur++;
+                    // The TT move was already returned in the TT_MOVE stage
+                    if (!(move == ttMove)) return true;
+                }
+                // Quiescence doesn't search captures that lose material
+                stage = !capturesOnly ? KILLERS : quietChecks ? GEN_QUIET_CHECKS : DONE;
+                break;
+
+            case KILLERS:
+                while (killerIdx < 2) {
+                    BitBoard::Move& killer = killers[killerIdx++];
+                    // Killers are quiet moves from a sibling node, they may not be legal here
+                    if (killer.valid() && !(killer == ttMove) && board.isLegalMove(killer)) {
+                        move = killer;
+                        return true;
+                    }
+                    killer = BitBoard::Move();
+                }
+                stage = COUNTER_MOVE;
+                break;
+
+            case COUNTER_MOVE:
+                stage = GEN_QUIETS;
+                // Same as the killers, and it may be one of them already
+                if (counterMove.valid() && !(counterMove == ttMove) && !(counterMove == killers[0])
+                    && !(counterMove == killers[1]) && board.isLegalMove(counterMove)) {
+                    move = counterMove;
+                    return true;
+                }
+                counterMove = BitBoard::Move();
+                break;
+
+            case GEN_QUIETS:
+                numMoves = numCaptures + board.getAvailableMoves(moves.data() + numCaptures, BitBoard::QUIETS);
+                scoreQuiets();
+                cur = numCaptures;
+                stage = QUIETS;
+                break;
+
+            case QUIETS:
+                while (cur < numMoves) {
+                    move = pickBest(numMoves);
+                    cur++;
+                    if (!isSearched(move)) return true;
+                }
+                cur = badCaptures;
+                stage = BAD_CAPTURES;
+                break;
+
+            case BAD_CAPTURES:
+                while (cur < numCaptures) {
+                    move = pickBest(numCaptures);
+                    cur++;
+                    if (!(move == ttMove)) return true;
+                }
+                stage = DONE;
+                break;
+
+            case GEN_EVASIONS:
+                numMoves = board.getAvailableMoves(moves.data(), BitBoard::EVASIONS);
+                scoreEvasions();
+                cur = 0;
+                stage = EVASIONS;
+                break;
+
+            case EVASIONS:
+                while (cur < numMoves) {
+                    move = pickBest(numMoves);
+                    cur++;
+                    if (!(move == ttMove)) return true;
+                }
+                stage = DONE;
+                break;
+
+            case GEN_QUIET_CHECKS:
+                numMoves = numCaptures + board.getAvailableMoves(moves.data() + numCaptures, BitBoard::QUIET_CHECKS);
+                for (uint8_t i = numCaptures; i < numMoves; i++) {
+                    scores[i] = board.see(moves[i]);
+                }
+                cur = numCaptures;
+                stage = QUIET_CHECKS;
+                break;
+
+            case QUIET_CHECKS:
+                if (cur < numMoves && checksLeft) {
+                    move = pickBest(numMoves);
+                    // Checking with a piece that just gets taken isn't forcing
+                    if (scores[cur] >= 0) {
+                        cur++;
+                        checksLeft--;
+                        return true;
+                    }
+                }
+                stage = DONE;
+                break;
+
+            case DONE:
+                return false;
+        }
+    }
+}
+
+// Selection sort step, most nodes cut off long before the list would be fully sorted
+BitBoard::Move MovePicker::pickBest(uint8_t const end) {
+    uint8_t best = cur;
+    for (uint8_t i = cur + 1; i < end; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves[cur], moves[best]);
+    std::swap(scores[cur], scores[best]);
+    return moves[cur];
+}
+
+// Only the quiet stage asks. Killers and the countermove are quiet moves and are compared
+// with their flags, so a capture between the same squares never counts as searched.
+bool MovePicker::isSearched(BitBoard::Move const& move) const {
+    return move == ttMove || move.data == killers[0].data || move.data == killers[1].data
+        || move.data == counterMove.data;
+}
+
+// Captures are ranked by what they win after the exchange, anything that
+// loses material is a bad capture
+void MovePicker::scoreCaptures() {
+    for (uint8_t i = 0; i < numCaptures; i++) {
+        scores[i] = board.see(moves[i]);
+    }
+}
+
+void MovePicker::scoreQuiets() {
+    static constexpr int32_t CASTLE_BONUS = 100;
+
+    float egBlend = board.calculateEndgameBlendFactor();
+    for (uint8_t i = numCaptures; i < numMoves; i++) {
+        BitBoard::Move const& m = moves[i];
+        scores[i] = board.pstDelta(m, egBlend);
+        scores[i] += m.isCastle() * CASTLE_BONUS;
+        scores[i] += board.getPieceValue(m.promote());
+        #ifdef HISTORY_HEURISTIC
+        scores[i] += board.tt->getHistoryScore(board.turn, m);
+        #endif
+    }
+}
+
+// Capturing the checker first, then king moves and blocks in the same order as quiets
+void MovePicker::scoreEvasions() {
+    static constexpr int32_t CAPTURE_BONUS = 1 << 16;
+
+    float egBlend = board.calculateEndgameBlendFactor();
+    for (uint8_t i = 0; i < numMoves; i++) {
+        BitBoard::Move const& m = moves[i];
+        if (m.isCapture()) {
+            scores[i] = CAPTURE_BONUS + board.see(m);
+        } else {
+            scores[i] = board.pstDelta(m, egBlend);
+            #ifdef HISTORY_HEURISTIC
+            scores[i] += board.tt->getHistoryScore(board.turn, m);
+            #endif
+        }
+    }
+}
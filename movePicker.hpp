@@ -0,0 +1,59 @@
+#ifndef __MOVE_PICKER_INC_GUARD__
+#define __MOVE_PICKER_INC_GUARD__
+
+#include <array>
+
+#include "bitboard.hpp"
+#include "defines.hpp"
+
+// Hands out moves one at a time in stages, so nodes that cut off early never
+// generate or score the moves they don't search:
+//   TT move -> good captures -> killers -> countermove -> quiets -> bad captures
+// In check there are only a few legal moves, so they are generated at once:
+//   TT move -> evasions
+// Quiescence only looks at good captures, and a few quiet checks if asked for:
+//   good captures -> quiet checks
+class MovePicker {
+    public:
+        enum Stage { TT_MOVE, GEN_CAPTURES, GOOD_CAPTURES, KILLERS, COUNTER_MOVE, GEN_QUIETS, QUIETS, BAD_CAPTURES,
+                     GEN_EVASIONS, EVASIONS, GEN_QUIET_CHECKS, QUIET_CHECKS, DONE };
+
+        // Main search, killers points to the two killer moves for this ply and counterMove
+        // is the quiet move that last refuted the opponent's previous move
+        MovePicker(BitBoard const& board, BitBoard::Move const& ttMove, BitBoard::Move const* killers,
+                   BitBoard::Move const& counterMove, bool inCheck);
+        // Quiescence, captures that don't lose material or every evasion when in check
+        MovePicker(BitBoard const& board, bool inCheck, bool quietChecks=false);
+
+        bool next(BitBoard::Move& move);
+        Stage getStage() const { return stage; }
+
+    private:
+        BitBoard::Move pickBest(uint8_t const end);
+        bool isSearched(BitBoard::Move const& move) const;
+        void scoreCaptures();
+        void scoreQuiets();
+        void scoreEvasions();
+
+        BitBoard const& board;
+        BitBoard::Move ttMove;
+        BitBoard::Move killers[2];
+        BitBoard::Move counterMove;
+        Stage stage;
+        bool capturesOnly;
+        bool inCheck;
+        bool quietChecks;
+
+        // Captures are generated into [0, numCaptures) and quiets after them. Bad
+        // captures stay where they are, from badCaptures up to numCaptures.
+        std::array<BitBoard::Move,MAX_MOVES> moves;
+        std::array<int32_t,MAX_MOVES> scores;
+        uint8_t cur;
+        uint8_t numCaptures;
+        uint8_t badCaptures;
+        uint8_t numMoves;
+        uint8_t killerIdx;
+        uint8_t checksLeft;
+};
+
+#endif
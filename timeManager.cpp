@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "timeManager.hpp"
+
+void TimeManager::init(Limits const& limits) {
+    start = std::chrono::high_resolution_clock::now();
+    lastIterationEnd = 0;
+    lastIterationTime = 0;
+    prevBestMove = BitBoard::Move();
+    prevEval = 0;
+    stableIterations = 0;
+
+    limited = limits.time || limits.moveTime;
+    fixed = limits.moveTime;
+    optimumTime = maximumTime = 0;
+
+    if (limits.moveTime) {
+        optimumTime = maximumTime = limits.moveTime;
+    } else if (limits.time) {
+        uint32_t available = (limits.time > TIME_BUFFER) ? limits.time - TIME_BUFFER : 1;
+        // Sudden death is treated as a fixed number of moves still to play
+        uint32_t movesToGo = limits.movesToGo ? std::min<uint32_t>(limits.movesToGo, TM_MOVES_TO_GO) : TM_MOVES_TO_GO;
+        // Only the last move before the time control may spend everything that is left
+        uint32_t cap = (movesToGo == 1) ? available : available / 2;
+
+        // Part of the increment is kept back so the clock still grows on easy moves
+        optimumTime = available / movesToGo + limits.inc * 3 / 4;
+        maximumTime = std::max<uint32_t>(1, std::min(optimumTime * TM_MAX_RATIO, cap));
+        optimumTime = std::min(optimumTime, maximumTime);
+    }
+}
+
+uint32_t TimeManager::elapsed() const {
+    const auto now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+}
+
+bool TimeManager::stopAfterIteration(BitBoard::Move const& bestMove, int32_t eval) {
+    // The longer a best move survives, the less likely more time changes it. Indexed
+    // by the number of iterations in a row it has stayed the same.
+    static constexpr float STABILITY_SCALE[4] = {1.2f, 0.9f, 0.7f, 0.5f};
+
+    uint32_t now = elapsed();
+    lastIterationTime = now - lastIterationEnd;
+    lastIterationEnd = now;
+
+    stableIterations = (bestMove == prevBestMove) ? std::min<uint8_t>(stableIterations + 1, 3) : 0;
+    int32_t scoreDrop = prevBestMove.valid() ? prevEval - eval : 0;
+    prevBestMove = bestMove;
+    prevEval = eval;
+
+    if (!limited) return false;
+
+    // The next iteration won't finish before the maximum, don't throw the time at it
+    if (now + lastIterationTime * TM_ITERATION_GROWTH > maximumTime) return true;
+    if (fixed) return false;
+
+    // Take longer while the score is falling, a little less while it's steady or rising
+    float scoreScale = std::clamp(1.0f + scoreDrop / 200.0f, 0.85f, 1.5f);
+    float target = optimumTime * STABILITY_SCALE[stableIterations] * scoreScale;
+    // An iteration takes at least as long as the last one, stop if that already overshoots
+    return now + lastIterationTime >= std::min<float>(target, maximumTime);
+}
@@ -0,0 +1,48 @@
+#ifndef __TIME_MANAGER_INC_GUARD__
+#define __TIME_MANAGER_INC_GUARD__
+
+#include <chrono>
+
+#include "bitboard.hpp"
+#include "defines.hpp"
+
+// Decides how long to think about a move. The clock gives an optimum time, which is
+// scaled after every iteration by how settled the search looks, and a maximum time
+// that the search is stopped at no matter what.
+class TimeManager {
+    public:
+        // Times in milliseconds, 0 when not given. Without time or moveTime the search
+        // only stops on depth, nodes, mate or a stop command.
+        struct Limits {
+            uint32_t time;
+            uint32_t inc;
+            uint32_t movesToGo;
+            uint32_t moveTime;
+            uint64_t nodes;     // Not time, but the engine stops on it from the same place
+            uint32_t mate;      // Stop once a mate in this many moves is found
+            bool ponder;        // No stopping on time before ponderhit, the clock still runs from go
+        };
+
+        void init(Limits const& limits);
+        uint32_t elapsed() const;
+        bool outOfTime() const { return limited && elapsed() >= maximumTime; }
+        // Called after each finished iteration, true if the next one shouldn't be started
+        bool stopAfterIteration(BitBoard::Move const& bestMove, int32_t eval);
+        uint32_t getOptimumTime() const { return optimumTime; }
+        uint32_t getMaximumTime() const { return maximumTime; }
+
+    private:
+        std::chrono::high_resolution_clock::time_point start;
+        uint32_t optimumTime;
+        uint32_t maximumTime;
+        bool limited;   // There is a time limit at all
+        bool fixed;     // movetime, the whole time is ours and there is nothing to save it for
+
+        uint32_t lastIterationEnd;
+        uint32_t lastIterationTime;
+        BitBoard::Move prevBestMove;
+        int32_t prevEval;
+        uint8_t stableIterations;
+};
+
+#endif
@@ -1,96 +1,216 @@
-#include <cstring>
-#include <assert.h>
-#include "transpositionTables.hpp"
-#include "bitboard.hpp"
-
-TT::TT()
-{
-    for (uint8_t c = 0; c < 2; c++) {
-        for (uint8_t pos = 0; pos < 64; pos++) {
-            for (uint8_t piece = 0; piece < 8; piece++) {
-                uint64_t random =
-                    (((uint64_t) rand() <<  0) & 0x000000000000FFFFull) | 
-                    (((uint64_t) rand() << 16) & 0x00000000FFFF0000ull) | 
-                    (((uint64_t) rand() << 32) & 0x0000FFFF00000000ull) |
-                    (((uint64_t) rand() << 48) & 0xFFFF000000000000ull);
-
-                BOARDPOS_HASH[c][piece][pos] = random;
-            }
-        }
-    }
-    clear();
-    clearHistory();
-}
-
-void TT::clearHistory() {
-    std::memset(&moveHistoryScore, 0, 64*64*2*sizeof(int32_t));
-}
-
-void TT::updateHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move, int32_t score) {
-    // History gravity formula
-    score = std::min(HISTORY_HEURISTIC_MAX_VALUE, std::max(HISTORY_HEURISTIC_MIN_VALUE, score));
-    score -= moveHistoryScore[turn][move.from][move.to] * std::abs(score) / HISTORY_HEURISTIC_MAX_VALUE;
-    moveHistoryScore[turn][move.from][move.to] += score;
-}
-
-int32_t TT::getHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move) {
-    return moveHistoryScore[turn][move.from][move.to];
-}
-
-TT::TTEntry& TT::lookupHash(uint64_t const hash) 
-{
-    size_t idx = getIdx(hash);
-    return table[idx];
-}
-
-void TT::clear() {
-    std::memset(&table, 0, sizeof(TTEntry)*TT_SIZE);
-}
-
-void TT::printEstimatedOccupancy() const
-{
-    uint32_t numTests = 10000;
-    uint32_t stride = TT_SIZE / numTests;
-    uint32_t numEmpty = 0;
-    for (uint32_t idx = 0; idx<numTests; idx++) {
-        numEmpty += !(table[idx*stride].hash);
-    }
-    std::cout << "Occupancy: " << std::to_string((float)(numTests-numEmpty)*100/numTests) 
-              << "%" << std::endl;
-}
-
-void TT::updateEntry(BitBoard const& board, BitBoard::Move const& move,
-                     int32_t const eval, uint8_t const depth, NodeType const node)
-{
-    TTEntry& entry = lookupHash(board.hash);
-    entry.eval = eval;
-    entry.depth = depth;
-    entry.hash = board.hash;
-    entry.move = move;
-    entry.node = node;
-}
-
-uint64_t TT::genHash(BitBoard const& board) const 
-{
-    using namespace BitBoardState;
-    uint64_t hash;
-    hash = board.turn == WHITE ? TURN_HASH_WHITE : 0;
-
-    hash ^= EN_PASSANT_HASH * board.s[WHITE].enPassantSquare;
-    hash ^= EN_PASSANT_HASH * board.s[BLACK].enPassantSquare;
-
-    hash ^= WHITE_CASTLE_LONG_HASH * board.s[WHITE].castleLong;
-    hash ^= WHITE_CASTLE_SHORT_HASH * board.s[WHITE].castleShort;
-    hash ^= BLACK_CASTLE_LONG_HASH * board.s[BLACK].castleLong;
-    hash ^= BLACK_CASTLE_SHORT_HASH * board.s[BLACK].castleShort;
-
-    for (uint8_t c = 0; c < 2; c++) {
-        for (uint8_t pos = 0; pos < 64; pos++) {
-            uint8_t pieceData = board.getPiece(board.p[c], pos);
-            if (pieceData) {
-                hash ^= BOARDPOS_HASH[c][pieceData][pos];
-            }
-        }
-    }
-    return hash;
-}
+#include <cstring>
+#include <assert.h>
+#include "transpositionTables.hpp"
+#include "bitboard.hpp"
+
+TT::TT()
+{
+    // xorshift64* with a fixed seed, so the keys are the same on every run
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    auto rand64 = [&seed]() {
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        return seed * 0x2545F4914F6CDD1Dull;
+    };
+
+    for (uint8_t c = 0; c < 2; c++) {
+        for (uint8_t pos = 0; pos < 64; pos++) {
+            for (uint8_t piece = 0; piece < 8; piece++) {
+                BOARDPOS_HASH[c][piece][pos] = rand64();
+            }
+        }
+    }
+    clear();
+    clearHistory();
+}
+
+void TT::clearHistory() {
+    std::memset(&moveHistoryScore, 0, 64*64*2*sizeof(int32_t));
+}
+
+void TT::updateHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move, int32_t score) {
+    // History gravity formula
+    score = std::min(HISTORY_HEURISTIC_MAX_VALUE, std::max(HISTORY_HEURISTIC_MIN_VALUE, score));
+    score -= moveHistoryScore[turn][move.from()][move.to()] * std::abs(score) / HISTORY_HEURISTIC_MAX_VALUE;
+    moveHistoryScore[turn][move.from()][move.to()] += score;
+}
+
+int32_t TT::getHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move) {
+    return moveHistoryScore[turn][move.from()][move.to()];
+}
+
+TT::TTEntry TT::lookupHash(uint64_t const hash) const
+{
+    TTSlot const& slot = table[getIdx(hash)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    TTEntry entry;
+    entry.hash = slot.key.load(std::memory_order_relaxed) ^ data;
+    entry.eval = static_cast<int32_t>(data & 0xffffffff);
+    entry.move.data = (data >> 32) & 0xffff;
+    entry.depth = (data >> 48) & 0xff;
+    entry.node = static_cast<NodeType>(data >> 56);
+    return entry;
+}
+
+void TT::clear() {
+    for (auto& slot : table) {
+        slot.key.store(0, std::memory_order_relaxed);
+        slot.data.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TT::printEstimatedOccupancy() const
+{
+    uint32_t numTests = 10000;
+    uint32_t stride = TT_SIZE / numTests;
+    uint32_t numEmpty = 0;
+    for (uint32_t idx = 0; idx<numTests; idx++) {
+        numEmpty += !(table[idx*stride].key.load(std::memory_order_relaxed));
+    }
+    std::cout << "Occupancy: " << std::to_string((float)(numTests-numEmpty)*100/numTests) 
+              << "%" << std::endl;
+}
+
+void TT::updateEntry(BitBoard const& board, BitBoard::Move const& move,
+                     int32_t const eval, uint8_t const depth, NodeType const node)
+{
+    TTSlot& slot = table[getIdx(board.hash)];
+    uint64_t data = static_cast<uint32_t>(eval)
+                  | (static_cast<uint64_t>(move.data) << 32)
+                  | (static_cast<uint64_t>(depth) << 48)
+                  | (static_cast<uint64_t>(node) << 56);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.key.store(board.hash ^ data, std::memory_order_relaxed);
+}
+
+uint64_t TT::genHash(BitBoard const& board) const 
+{
+    using namespace BitBoardState;
+    uint64_t hash;
+    hash = board.turn == WHITE ? TURN_HASH_WHITE : 0;
+
+    hash ^= EN_PASSANT_HASH * board.s[WHITE].enPassantSquare;
+    hash ^= EN_PASSANT_HASH * board.s[BLACK].enPassantSquare;
+
+    hash ^= WHITE_CASTLE_LONG_HASH * board.s[WHITE].castleLong;
+    hash ^= WHITE_CASTLE_SHORT_HASH * board.s[WHITE].castleShort;
+    hash ^= BLACK_CASTLE_LONG_HASH * board.s[BLACK].castleLong;
+    hash ^= BLACK_CASTLE_SHORT_HASH * board.s[BLACK].castleShort;
+
+    for (uint8_t c = 0; c < 2; c++) {
+        uint64_t occupied = board.p[c].pawn | board.p[c].knight | board.p[c].bishop
+                          | board.p[c].rook | board.p[c].queen | board.p[c].king;
+        while (occupied) {
+            uint8_t pos = __builtin_ctzll(occupied);
+            hash ^= BOARDPOS_HASH[c][board.pieceOn[pos]][pos];
+            occupied &= occupied - 1;
+        }
+    }
+    return hash;
+}
+
+uint64_t TT::genPawnKey(BitBoard const& board) const
+{
+    using namespace BitBoardState;
+    uint64_t key = 0;
+    for (uint8_t c = 0; c < 2; c++) {
+        uint64_t pieces = board.p[c].pawn | board.p[c].king;
+        while (pieces) {
+            uint8_t pos = __builtin_ctzll(pieces);
+            key ^= BOARDPOS_HASH[c][board.pieceOn[pos]][pos];
+            pieces &= pieces - 1;
+        }
+    }
+    return key;
+}
+
+uint64_t TT::genMaterialKey(BitBoard const& board) const
+{
+    using namespace BitBoardState;
+    uint64_t key = 0;
+    for (uint8_t c = 0; c < 2; c++) {
+        uint64_t const bb[7] = {0, board.p[c].pawn, board.p[c].rook, board.p[c].knight,
+                                board.p[c].bishop, board.p[c].queen, board.p[c].king};
+        for (uint8_t piece = PAWN; piece <= KING; piece++) {
+            for (uint8_t n = 0; n < __builtin_popcountll(bb[piece]); n++) {
+                key ^= BOARDPOS_HASH[c][piece][n];
+            }
+        }
+    }
+    return key;
+}
+
+uint64_t TT::genNonPawnKey(BitBoard const& board, bool c) const
+{
+    uint64_t key = 0;
+    uint64_t pieces = board.p[c].knight | board.p[c].bishop | board.p[c].rook
+                    | board.p[c].queen | board.p[c].king;
+    while (pieces) {
+        uint8_t pos = __builtin_ctzll(pieces);
+        key ^= BOARDPOS_HASH[c][board.pieceOn[pos]][pos];
+        pieces &= pieces - 1;
+    }
+    return key;
+}
+
+PerftTT::PerftTT(size_t const megabytes)
+    : probes(0), hits(0)
+{
+    // Round down to a power of two number of entries so the index is a mask
+    size_t entries = std::max<size_t>(1, (megabytes << 20) / sizeof(PerftEntry));
+    entries = 1ull << (63 - __builtin_clzll(entries));
+    mask = entries - 1;
+    sizeMb = megabytes;
+    table = new PerftEntry[entries];
+    clear();
+}
+
+PerftTT::~PerftTT() {
+    delete[] table;
+}
+
+void PerftTT::clear() {
+    for (size_t idx = 0; idx <= mask; idx++) {
+        table[idx].key.store(0, std::memory_order_relaxed);
+        for (auto& count : table[idx].counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+    probes = 0;
+    hits = 0;
+}
+
+bool PerftTT::probe(uint64_t const hash, uint8_t const depth, bool const bulk, Engine::PerftResult& result) {
+    uint64_t key = getKey(hash, depth, bulk);
+    PerftEntry const& entry = table[key & mask];
+    uint64_t counts[7];
+    uint64_t check = entry.key.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < 7; i++) {
+        counts[i] = entry.counts[i].load(std::memory_order_relaxed);
+        check ^= counts[i];
+    }
+    if (check != key) return false;
+
+    std::memcpy(&result, counts, sizeof(counts));
+    return true;
+}
+
+// Always replace, recent subtrees are the ones most likely to be reached again
+void PerftTT::store(uint64_t const hash, uint8_t const depth, bool const bulk, Engine::PerftResult const& result) {
+    uint64_t key = getKey(hash, depth, bulk);
+    PerftEntry& entry = table[key & mask];
+    uint64_t counts[7];
+    std::memcpy(counts, &result, sizeof(counts));
+    for (uint8_t i = 0; i < 7; i++) {
+        entry.counts[i].store(counts[i], std::memory_order_relaxed);
+        key ^= counts[i];
+    }
+    entry.key.store(key, std::memory_order_relaxed);
+}
+
+void PerftTT::printStats() const {
+    std::cout << "Perft hash " << std::to_string(sizeMb) << "MB: " << std::to_string(hits) << "/"
+              << std::to_string(probes) << " hits ("
+              << std::to_string(probes ? (float)hits*100/probes : 0.0f) << "%)" << std::endl;
+}
@@ -1,51 +1,102 @@
-#ifndef __TRANSPOSITION_TABLES_INC_GUARD__
-#define __TRANSPOSITION_TABLES_INC_GUARD__
-
-#include <iostream>
-#include <assert.h>
-#include <vector>
-#include <algorithm>
-#include <unordered_map>
-#include <array>
-
-#include "defines.hpp"
-#include "bitboard.hpp"
-
-class TT {
-    public:
-        enum NodeType { PV, CUT, ALL};
-
-        typedef struct TTEntry {
-            uint64_t hash;
-            BitBoard::Move move;
-            int32_t eval;
-            uint8_t depth;
-            NodeType node;
-        } TTEntry;
-
-        TT();
-        TTEntry& lookupHash(uint64_t const hash);
-        void updateEntry(BitBoard const& board, BitBoard::Move const& move,
-                         int32_t const eval, uint8_t const depth, NodeType const node);
-        uint64_t genHash(BitBoard const& board) const;
-        void clear();
-        void printEstimatedOccupancy() const;
-        void clearHistory();
-        void updateHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move, int32_t score);
-        int32_t getHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move);
-
-        // [turn][piece][square]
-        uint64_t BOARDPOS_HASH[2][8][64];
-
-    private:
-        static inline size_t getIdx(uint64_t hash) {
-            return hash & (0xffffffffffffffffull >> (64 - TT_SIZE_LOG2));
-        };
-
-        TTEntry table[TT_SIZE];
-
-        // [turn][from][to]
-        int32_t moveHistoryScore[2][64][64];
-};
-
+#ifndef __TRANSPOSITION_TABLES_INC_GUARD__
+#define __TRANSPOSITION_TABLES_INC_GUARD__
+
+#include <iostream>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <array>
+#include <atomic>
+
+#include "defines.hpp"
+#include "bitboard.hpp"
+#include "engine.hpp"
+
+class TT {
+    public:
+        enum NodeType : uint8_t { PV, CUT, ALL};
+
+        typedef struct TTEntry {
+            uint64_t hash;
+            int32_t eval;
+            BitBoard::Move move;
+            uint8_t depth;
+            NodeType node;
+        } TTEntry;
+
+        TT();
+        TTEntry lookupHash(uint64_t const hash) const;
+        void updateEntry(BitBoard const& board, BitBoard::Move const& move,
+                         int32_t const eval, uint8_t const depth, NodeType const node);
+        uint64_t genHash(BitBoard const& board) const;
+        uint64_t genPawnKey(BitBoard const& board) const;
+        uint64_t genMaterialKey(BitBoard const& board) const;
+        uint64_t genNonPawnKey(BitBoard const& board, bool c) const;
+        void clear();
+        void printEstimatedOccupancy() const;
+        void clearHistory();
+        void updateHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move, int32_t score);
+        int32_t getHistoryScore(BitBoardState::Color turn, BitBoard::Move const& move);
+
+        // [turn][piece][square]
+        uint64_t BOARDPOS_HASH[2][8][64];
+
+    private:
+        static inline size_t getIdx(uint64_t hash) {
+            return hash & (0xffffffffffffffffull >> (64 - TT_SIZE_LOG2));
+        };
+
+        // Search threads share the table without locks. A slot holds the entry packed
+        // into one word and the hash xored with it, so a slot torn by two threads
+        // writing at once comes back with the wrong hash and reads as a miss.
+        struct TTSlot {
+            std::atomic<uint64_t> key;
+            std::atomic<uint64_t> data;
+        };
+        static_assert(sizeof(TTSlot) == 16, "Four TT slots per cache line");
+
+        TTSlot table[TT_SIZE];
+
+        // [turn][from][to]
+        int32_t moveHistoryScore[2][64][64];
+};
+
+static_assert(sizeof(BitBoard::Move) + sizeof(int32_t) + 2 == sizeof(uint64_t), "TT entry data packs into one word");
+
+// Perft counters per position and remaining depth, shared by all perft threads
+// without locks. The key is stored xored with every counter, so an entry torn by
+// two threads writing at once fails the key check and reads as a miss.
+class PerftTT {
+    public:
+        PerftTT(size_t const megabytes);
+        ~PerftTT();
+        bool probe(uint64_t const hash, uint8_t const depth, bool const bulk, Engine::PerftResult& result);
+        void store(uint64_t const hash, uint8_t const depth, bool const bulk, Engine::PerftResult const& result);
+        void clear();
+        void printStats() const;
+        // Probe counts are kept by the perft threads and added once they have joined
+        void addStats(uint64_t const numProbes, uint64_t const numHits) { probes += numProbes; hits += numHits; }
+        size_t getSizeMb() const { return sizeMb; }
+
+    private:
+        struct alignas(64) PerftEntry {
+            std::atomic<uint64_t> key;
+            std::atomic<uint64_t> counts[7];
+        };
+
+        // Bulk counted subtrees have different counters, so they get their own keys
+        static inline uint64_t getKey(uint64_t const hash, uint8_t const depth, bool const bulk) {
+            return hash ^ (PERFT_DEPTH_HASH * (2*depth + bulk));
+        }
+
+        PerftEntry* table;
+        size_t mask;
+        size_t sizeMb;
+        uint64_t probes;
+        uint64_t hits;
+};
+
+static_assert(sizeof(Engine::PerftResult) == 7*sizeof(uint64_t), "PerftTT stores the seven perft counters");
+
 #endif
\ No newline at end of file